@@ -0,0 +1,32 @@
+#include <chrono>
+#include <iostream>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+int main(int, char**)
+{
+  // Poll a message with an adaptive frequency while the load of the flight controller changes, against the in-memory
+  // simulator. The service time emulates the MSP task of the flight controller slowed down by heavy OSD or blackbox
+  auto [fc, client] = mspfci::LoopbackTransport::pair();
+  mspfci::Simulator sim(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR), std::move(fc));
+  mspfci::Interface inter(std::move(client), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  std::atomic<uint64_t> received = 0;
+  const size_t id = inter.subscribe<mspfci::Imu>(10.0, [&received](const mspfci::Imu&) { ++received; });
+  [[maybe_unused]] const bool succeeded = inter.setSubscriptionAdaptive(id, 10.0, 2000.0);
+
+  for (const auto& service_time : {0, 2000, 5000, 500, 0})
+  {
+    sim.setServiceTime(std::chrono::microseconds(service_time));
+    const uint64_t start = received;
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    const mspfci::RateStats stats = inter.getSubscriptionRateStats(id);
+    std::cout << "Service time " << service_time << " us: " << (received - start) / 2 << " messages/s, frequency "
+              << inter.getSubscriptionFrequency(id) << " Hz, " << stats.decreases << " decreases ("
+              << stats.failures << " failures, " << stats.slow << " slow, " << stats.overruns << " overruns)"
+              << std::endl;
+  }
+
+  return 0;
+}
\ No newline at end of file
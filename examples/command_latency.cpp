@@ -0,0 +1,53 @@
+#include <chrono>
+#include <iostream>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+int main(int argc, char** argv)
+{
+  // Measure the latency of the control commands while telemetry is being polled, against a SITL exposing MSP over
+  // TCP, or against the in-memory simulator
+  // Usage: command_latency [host port]
+  std::unique_ptr<mspfci::Simulator> sim;
+  std::unique_ptr<mspfci::Transport> transport;
+  if (argc > 2)
+  {
+    transport = std::make_unique<mspfci::TcpTransport>(argv[1], static_cast<uint16_t>(std::stoi(argv[2])));
+  }
+  else
+  {
+    auto [fc, client] = mspfci::LoopbackTransport::pair();
+    sim = std::make_unique<mspfci::Simulator>(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR),
+                                              std::move(fc));
+    transport = std::move(client);
+  }
+
+  // Instanciate interface
+  mspfci::Interface inter(std::move(transport), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  // Poll telemetry as fast as possible
+  inter.subscribe<mspfci::Imu>(10000.0, [](const mspfci::Imu&) {});
+  inter.subscribe<mspfci::Altitude>(10000.0, [](const mspfci::Altitude&) {});
+
+  // Update the setpoint at 1 kHz, the RC stream sends the latest one at 50 Hz
+  size_t failed = 0;
+  const size_t n = 2000;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (!inter.trpy(1000 + static_cast<uint16_t>(i % 1000), 1500, 1500, 1500))
+    {
+      ++failed;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Report setpoint updates and command latency
+  const mspfci::LatencyStats latency = inter.getCommandLatency();
+  std::cout << inter.getRCStream().getUpdates() << " setpoint updates, " << failed << " failures, "
+            << inter.getRCStream().getFrames() << " RC frames sent" << std::endl;
+  std::cout << "Command latency: mean " << std::chrono::duration<double, std::micro>(latency.mean()).count()
+            << " us, max " << std::chrono::duration<double, std::micro>(latency.max).count() << " us" << std::endl;
+
+  return 0;
+}
\ No newline at end of file
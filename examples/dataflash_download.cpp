@@ -0,0 +1,56 @@
+#include <iostream>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+int main(int argc, char** argv)
+{
+  // Download the blackbox log from the onboard flash of a flight controller, or of the in-memory simulator
+  // Usage: dataflash_download output [port [window]]
+  if (argc < 2)
+  {
+    std::cerr << "Usage: dataflash_download output [port [window]]" << std::endl;
+    return 1;
+  }
+  std::unique_ptr<mspfci::Simulator> sim;
+  std::unique_ptr<mspfci::Transport> transport;
+  if (argc > 2 && std::string(argv[2]) != "sim")
+  {
+    transport = std::make_unique<mspfci::SerialTransport>(argv[2], 115200);
+  }
+  else
+  {
+    auto [fc, client] = mspfci::LoopbackTransport::pair();
+    sim = std::make_unique<mspfci::Simulator>(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR),
+                                              std::move(fc));
+    transport = std::move(client);
+  }
+
+  // Instanciate interface
+  mspfci::Interface inter(std::move(transport), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+  mspfci::DataflashDownloader& dataflash = inter.getDataflash();
+  if (argc > 3)
+  {
+    dataflash.setWindow(std::stoul(argv[3]));
+  }
+
+  // Download, reporting the progress every 10%
+  uint64_t next_report = 0;
+  mspfci::DownloadProgress last;
+  const bool succeeded = dataflash.download(argv[1], [&next_report, &last](const mspfci::DownloadProgress& progress) {
+    last = progress;
+    if (progress.stored >= next_report)
+    {
+      std::cout << progress.stored << "/" << progress.total << " bytes, " << progress.throughput() / 1024.0
+                << " KiB/s" << std::endl;
+      next_report += progress.total / 10;
+    }
+  });
+
+  // Report
+  std::cout << (succeeded ? "Downloaded " : "Failed after ") << last.downloaded << " bytes in "
+            << std::chrono::duration<double>(last.elapsed).count() << " s, " << last.throughput() / 1024.0
+            << " KiB/s" << std::endl;
+
+  return succeeded ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "mspfci/fleet_manager.hpp"
+#include "mspfci/io_backend.hpp"
+#include "mspfci/simulator.hpp"
+
+int main(int argc, char** argv)
+{
+  // Drive a fleet of simulated flight controllers, each one behind a pty, from a pool of event loops, and report the
+  // messages per second
+  // Usage: fleet_benchmark [flight controllers [loops [frequency]]]
+  const size_t n = argc > 1 ? std::stoul(argv[1]) : 8;
+  const size_t loops = argc > 2 ? std::stoul(argv[2]) : 1;
+  const float freq = argc > 3 ? std::stof(argv[3]) : 1000.0f;
+
+  auto logger = std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR);
+  mspfci::FleetManager fleet(logger, loops, true);
+  std::vector<std::unique_ptr<mspfci::Simulator>> sims;
+  for (size_t i = 0; i < n; ++i)
+  {
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+      std::cerr << "Failed to open a pty" << std::endl;
+      return 1;
+    }
+    sims.push_back(std::make_unique<mspfci::Simulator>(
+        logger, std::make_unique<mspfci::AsyncSerialTransport>(master, mspfci::IoBackend::EPOLL)));
+    fleet.add(ptsname(master));
+  }
+
+  // Subscribe to the IMU of every flight controller
+  std::atomic<uint64_t> received = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (!fleet.subscribe<mspfci::Imu>(i, freq, [&received](const size_t&, const mspfci::Msg&) { ++received; }))
+    {
+      return 1;
+    }
+  }
+
+  // Run
+  const auto start_time = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+  const uint64_t count = received;
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_time;
+
+  // Report
+  std::cout << n << " flight controllers, " << loops << " loops: " << static_cast<double>(count) / duration.count()
+            << " msg/s" << std::endl;
+  for (size_t i = 0; i < n; ++i)
+  {
+    const mspfci::FleetStats stats = fleet.getStats(i);
+    std::cout << "  fc " << i << ": " << stats.responses << " responses, " << stats.timeouts << " timeouts, "
+              << stats.crc_errors << " crc errors, round trip mean "
+              << std::chrono::duration<double, std::micro>(stats.latency.mean()).count() << " us, max "
+              << std::chrono::duration<double, std::micro>(stats.latency.max).count() << " us" << std::endl;
+  }
+
+  return 0;
+}
\ No newline at end of file
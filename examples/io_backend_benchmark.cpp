@@ -0,0 +1,127 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/io_backend.hpp"
+#include "mspfci/simulator.hpp"
+
+/**
+ * @brief Get the CPU time (user and system) used by the process
+ * @return CPU time in seconds (double)
+ */
+double cpuTime()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+/**
+ * @brief Measure the telemetry round trips, the system calls and the CPU time per frame of a backend
+ * @param port (const reference to std::string)
+ * @param baudrate (uint32_t)
+ * @param backend backend, or none for the synchronous SerialTransport (pointer to const IoBackend)
+ * @param name name of the configuration (const reference to std::string)
+ */
+void benchmark(const std::string& port, uint32_t baudrate, const mspfci::IoBackend* backend, const std::string& name)
+{
+  std::unique_ptr<mspfci::Transport> transport;
+  mspfci::AsyncSerialTransport* async = nullptr;
+  if (backend)
+  {
+    auto async_transport = std::make_unique<mspfci::AsyncSerialTransport>(port, baudrate, *backend);
+    async = async_transport.get();
+    transport = std::move(async_transport);
+  }
+  else
+  {
+    transport = std::make_unique<mspfci::SerialTransport>(port, baudrate);
+  }
+
+  // Instanciate interface
+  mspfci::Interface inter(std::move(transport), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  // Loop
+  mspfci::Imu imu;
+  size_t failed = 0;
+  const size_t n = 2000;
+  const uint64_t syscalls = async ? async->getSyscalls() : 0;
+  const uint64_t frames = async ? async->getFrames() : 0;
+  const double cpu_time = cpuTime();
+  const auto start_time = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (!inter.read(imu))
+    {
+      ++failed;
+    }
+  }
+  const auto end_time = std::chrono::steady_clock::now();
+
+  // Report round trips, system calls and CPU time per frame
+  std::chrono::duration<double> duration = end_time - start_time;
+  std::cout << name << ": " << n << " round trips, " << failed << " failures, mean "
+            << duration.count() / static_cast<double>(n) * 1e6 << " us, CPU "
+            << (cpuTime() - cpu_time) / static_cast<double>(n) * 1e6 << " us/frame";
+  if (async)
+  {
+    std::cout << ", " << static_cast<double>(async->getSyscalls() - syscalls) /
+                             static_cast<double>(async->getFrames() - frames)
+              << " syscalls/frame";
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  // Compare the I/O backends of the serial transport, against a serial port or against the simulator behind a pty
+  // Usage: io_backend_benchmark [port [baudrate]]
+  std::unique_ptr<mspfci::Simulator> sim;
+  std::string port;
+  uint32_t baudrate = 115200;
+  if (argc > 1)
+  {
+    port = argv[1];
+    baudrate = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : baudrate;
+  }
+  else
+  {
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+      std::cerr << "Failed to open a pty" << std::endl;
+      return 1;
+    }
+    port = ptsname(master);
+
+    // Keep the slave side open, the master hangs up whenever the last slave is closed
+    if (open(port.c_str(), O_RDWR | O_NOCTTY) == -1)
+    {
+      std::cerr << "Failed to open " << port << std::endl;
+      return 1;
+    }
+    sim = std::make_unique<mspfci::Simulator>(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR),
+                                              std::make_unique<mspfci::AsyncSerialTransport>(master,
+                                                                                             mspfci::IoBackend::EPOLL));
+  }
+
+  std::cout << "io_uring " << (mspfci::AsyncSerialTransport::uringAvailable() ? "available" : "not available")
+            << std::endl;
+
+  benchmark(port, baudrate, nullptr, "serial");
+  const mspfci::IoBackend epoll = mspfci::IoBackend::EPOLL;
+  benchmark(port, baudrate, &epoll, "epoll");
+  if (mspfci::AsyncSerialTransport::uringAvailable())
+  {
+    const mspfci::IoBackend uring = mspfci::IoBackend::IO_URING;
+    benchmark(port, baudrate, &uring, "io_uring");
+  }
+
+  return 0;
+}
\ No newline at end of file
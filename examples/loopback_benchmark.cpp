@@ -0,0 +1,55 @@
+#include <chrono>
+#include <iostream>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+int main(int argc, char** argv)
+{
+  // Benchmark the protocol round trip against a SITL exposing MSP over TCP, or against the in-memory simulator
+  // Usage: loopback_benchmark [host port]
+  std::unique_ptr<mspfci::Simulator> sim;
+  std::unique_ptr<mspfci::Transport> transport;
+  if (argc > 2)
+  {
+    transport = std::make_unique<mspfci::TcpTransport>(argv[1], static_cast<uint16_t>(std::stoi(argv[2])));
+  }
+  else
+  {
+    auto [fc, client] = mspfci::LoopbackTransport::pair();
+    sim = std::make_unique<mspfci::Simulator>(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR),
+                                              std::move(fc));
+    transport = std::move(client);
+  }
+
+  // Instanciate interface
+  mspfci::Interface inter(std::move(transport), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  // Define data
+  mspfci::Imu imu;
+  size_t failed = 0;
+  const size_t n = 100000;
+
+  // Start time
+  const auto start_time = std::chrono::steady_clock::now();
+
+  // Loop
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (!inter.read(imu))
+    {
+      ++failed;
+    }
+  }
+
+  // End time
+  const auto end_time = std::chrono::steady_clock::now();
+
+  // Report round trips
+  std::chrono::duration<double> duration = end_time - start_time;
+  std::cout << n << " round trips in " << duration.count() << " s, " << failed << " failures" << std::endl;
+  std::cout << "Round trip: " << duration.count() / static_cast<double>(n) * 1e6 << " us, "
+            << static_cast<double>(n) / duration.count() << " msg/s" << std::endl;
+
+  return 0;
+}
\ No newline at end of file
@@ -13,9 +13,9 @@ int main(int, char**)
   // Instanciate interface
   mspfci::Interface inter(port, baudrate);
 
-  // Register callbacks
-  inter.registerCallback<mspfci::Imu>(200.0, [&inter](const mspfci::Msg& msg) { inter.logger_->info(msg); });
-  // inter.registerCallback<mspfci::Altitude>(100.0, [&inter](const mspfci::Msg& msg) { inter.logger_->info(msg); });
+  // Subscribe to messages
+  inter.subscribe<mspfci::Imu>(200.0, [&inter](const mspfci::Imu& imu) { inter.logger_->info(imu); });
+  // inter.subscribe<mspfci::Altitude>(100.0, [&inter](const mspfci::Altitude& alt) { inter.logger_->info(alt); });
 
   while (true)
   {
@@ -0,0 +1,73 @@
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <iostream>
+
+#include "mspfci/interface.hpp"
+
+// Minimal fire and forget coroutine
+struct Task
+{
+  struct promise_type
+  {
+    Task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Read imu and altitude concurrently from coroutines, without dedicating a thread to each
+Task readImu(mspfci::Interface& inter, std::atomic_int& pending)
+{
+  for (size_t i = 0; i < 100; ++i)
+  {
+    if (auto imu = co_await inter.readAsync<mspfci::Imu>())
+    {
+      inter.logger_->info(*imu);
+    }
+  }
+  --pending;
+}
+
+Task readAltitude(mspfci::Interface& inter, std::atomic_int& pending)
+{
+  for (size_t i = 0; i < 100; ++i)
+  {
+    if (auto altitude = co_await inter.readAsync<mspfci::Altitude>())
+    {
+      inter.logger_->info(*altitude);
+    }
+  }
+  --pending;
+}
+
+int main(int, char**)
+{
+  std::string port = "/dev/ttyACM0";
+  uint32_t baudrate = 115200;
+
+  // Instanciate interface
+  mspfci::Interface inter(port, baudrate, mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::INFO);
+
+  // Start coroutines
+  std::atomic_int pending = 2;
+  readImu(inter, pending);
+  readAltitude(inter, pending);
+
+  // Future based read
+  auto imu = inter.readFuture<mspfci::Imu>().get();
+  if (imu)
+  {
+    inter.logger_->info(*imu);
+  }
+
+  // Wait for coroutines to complete
+  while (pending > 0)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  return 0;
+}
\ No newline at end of file
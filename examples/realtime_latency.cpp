@@ -0,0 +1,104 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+/**
+ * @brief Measure the deviation of the intervals of a 1 kHz subscription from its period, and print their histogram
+ * @param inter (reference to mspfci::Interface)
+ * @param title (const reference to std::string)
+ */
+void measure(mspfci::Interface& inter, const std::string& title)
+{
+  const auto period = std::chrono::milliseconds(1);
+  std::vector<std::chrono::steady_clock::time_point> stamps(3000);
+  std::atomic<size_t> received = 0;
+  const size_t id = inter.subscribe<mspfci::Imu>(1000.0, [&stamps, &received](const mspfci::Imu&) {
+    const size_t i = received.load();
+    if (i < stamps.size())
+    {
+      stamps[i] = std::chrono::steady_clock::now();
+      received = i + 1;
+    }
+  });
+  while (received < stamps.size())
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  [[maybe_unused]] const bool succeeded = inter.unsubscribe(id);
+
+  // Histogram of the deviations
+  const std::array<int64_t, 7> bounds = {50, 100, 250, 500, 1000, 2000, 5000};
+  std::array<size_t, bounds.size() + 1> counts = {};
+  int64_t max = 0;
+  for (size_t i = 1; i < stamps.size(); ++i)
+  {
+    const int64_t interval = std::chrono::duration_cast<std::chrono::microseconds>(stamps[i] - stamps[i - 1]).count();
+    const int64_t deviation = std::abs(interval - period.count() * 1000);
+    max = std::max(max, deviation);
+    size_t bucket = 0;
+    while (bucket < bounds.size() && deviation >= bounds[bucket])
+    {
+      ++bucket;
+    }
+    ++counts[bucket];
+  }
+  std::cout << title << " (max " << max << " us)" << std::endl;
+  for (size_t bucket = 0; bucket < counts.size(); ++bucket)
+  {
+    std::cout << "  " << (bucket < bounds.size() ? "< " + std::to_string(bounds[bucket]) : ">= 5000") << " us: "
+              << std::setw(5) << counts[bucket] << " " << std::string(counts[bucket] * 60 / stamps.size(), '#')
+              << std::endl;
+  }
+}
+
+int main(int, char**)
+{
+  // Measure the scheduling jitter of a subscription competing with busy threads (e.g. a vision pipeline), with the
+  // default scheduling, then with SCHED_FIFO and locked memory. Needs CAP_SYS_NICE and CAP_IPC_LOCK (e.g. root)
+  auto [fc, client] = mspfci::LoopbackTransport::pair();
+  mspfci::Simulator sim(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR), std::move(fc));
+  mspfci::Interface inter(std::move(client), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  // Load, one busy thread per core
+  std::atomic_bool loaded = true;
+  std::vector<std::thread> load;
+  for (unsigned int i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i)
+  {
+    load.emplace_back([&loaded]() {
+      volatile uint64_t x = 0;
+      while (loaded)
+      {
+        x = x + 1;
+      }
+    });
+  }
+
+  measure(inter, "SCHED_OTHER");
+
+  // The simulator stands for the flight controller, scheduled as the I/O threads
+  mspfci::RealtimeConfig config;
+  config.policy = SCHED_FIFO;
+  config.io_priority = 80;
+  config.callback_priority = 70;
+  config.lock_memory = true;
+  config.prefault_heap = 16 << 20;
+  sim.setSpinTime(config.spin_time);
+  const bool applied = inter.setRealtime(config) &&
+                       mspfci::configureThread(inter.logger_, sim.getNativeHandle(), "simulator", SCHED_FIFO, 80, {});
+  measure(inter, applied ? "SCHED_FIFO, locked memory" : "Real-time configuration failed");
+
+  loaded = false;
+  for (auto& th : load)
+  {
+    th.join();
+  }
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <iostream>
+
+#include "mspfci/msp.hpp"
+#include "mspfci/replay.hpp"
+
+// Build a MSPv1 response frame
+mspfci::Bytes frame(const mspfci::MSPCode& code, const mspfci::Bytes& payload)
+{
+  mspfci::Bytes msg = {'$', 'M', '>', static_cast<uint8_t>(payload.size()), static_cast<uint8_t>(code)};
+  uint8_t crc = static_cast<uint8_t>(payload.size()) ^ static_cast<uint8_t>(code);
+  for (const auto& it : payload)
+  {
+    msg.push_back(it);
+    crc ^= it;
+  }
+  msg.push_back(crc);
+  return msg;
+}
+
+int main(int argc, char** argv)
+{
+  // Replay the given recording (see mspfci::RecordingTransport), or a synthetic stream of imu and altitude frames
+  // Usage: replay [recording] [speed]
+  const double speed = argc > 2 ? std::stod(argv[2]) : 0.0;
+  std::unique_ptr<mspfci::ReplayTransport> replay;
+  if (argc > 1)
+  {
+    replay = std::make_unique<mspfci::ReplayTransport>(argv[1], speed);
+  }
+  else
+  {
+    std::vector<mspfci::ReplayChunk> chunks;
+    for (size_t i = 0; i < 100000; ++i)
+    {
+      const auto time = std::chrono::nanoseconds(i * 5000000);
+      chunks.push_back({time, frame(mspfci::MSPCode::MSP_RAW_IMU, mspfci::Bytes(18, static_cast<uint8_t>(i)))});
+      chunks.push_back({time, frame(mspfci::MSPCode::MSP_ALTITUDE, mspfci::Bytes(6, static_cast<uint8_t>(i)))});
+    }
+    replay = std::make_unique<mspfci::ReplayTransport>(std::move(chunks), speed);
+  }
+  mspfci::ReplayTransport* stream = replay.get();
+
+  // Instanciate msp on the replayed stream
+  auto logger = std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::WARN);
+  mspfci::MSP msp(logger, std::move(replay), mspfci::MSPVer::MSPv1);
+
+  // Define data
+  mspfci::Imu imu;
+  mspfci::Altitude altitude;
+  mspfci::Bytes data;
+  mspfci::MSPCode code;
+  size_t decoded = 0;
+  size_t failed = 0;
+
+  // Start time
+  const auto start_time = std::chrono::steady_clock::now();
+
+  // Loop until the stream is exhausted
+  while (stream->isOpen())
+  {
+    data.clear();
+    if (!msp.receive(code, data))
+    {
+      ++failed;
+      continue;
+    }
+
+    bool succeeded = false;
+    switch (code)
+    {
+      case mspfci::MSPCode::MSP_RAW_IMU:
+        succeeded = imu.decodeMessage(data);
+        break;
+      case mspfci::MSPCode::MSP_ALTITUDE:
+        succeeded = altitude.decodeMessage(data);
+        break;
+      default:
+        break;
+    }
+    succeeded ? ++decoded : ++failed;
+  }
+
+  // End time
+  const auto end_time = std::chrono::steady_clock::now();
+
+  // Report throughput
+  std::chrono::duration<double> duration = end_time - start_time;
+  const double bytes = static_cast<double>(stream->getBytesReplayed());
+  std::cout << "Replayed " << bytes << " bytes in " << duration.count() << " s" << std::endl;
+  std::cout << "Decoded " << decoded << " messages, " << failed << " failures" << std::endl;
+  std::cout << "Throughput: " << bytes / duration.count() * 1e-9 << " GB/s, "
+            << static_cast<double>(decoded) / duration.count() << " msg/s" << std::endl;
+
+  return 0;
+}
\ No newline at end of file
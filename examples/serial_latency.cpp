@@ -0,0 +1,65 @@
+#include <chrono>
+#include <iostream>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+/**
+ * @brief Measure the round trip latency of telemetry reads
+ * @param transport (std::unique_ptr<mspfci::Transport>)
+ * @param name name of the configuration (const reference to std::string)
+ */
+void benchmark(std::unique_ptr<mspfci::Transport> transport, const std::string& name)
+{
+  // Instanciate interface
+  mspfci::Interface inter(std::move(transport), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  // Loop
+  mspfci::Imu imu;
+  size_t failed = 0;
+  const size_t n = 1000;
+  std::chrono::nanoseconds max = std::chrono::nanoseconds::zero();
+  const auto start_time = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i)
+  {
+    const auto read_time = std::chrono::steady_clock::now();
+    if (!inter.read(imu))
+    {
+      ++failed;
+    }
+    max = std::max<std::chrono::nanoseconds>(max, std::chrono::steady_clock::now() - read_time);
+  }
+  const auto end_time = std::chrono::steady_clock::now();
+
+  // Report round trips
+  std::chrono::duration<double> duration = end_time - start_time;
+  std::cout << name << ": " << n << " round trips, " << failed << " failures, mean "
+            << duration.count() / static_cast<double>(n) * 1e6 << " us, max "
+            << std::chrono::duration<double, std::micro>(max).count() << " us" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  // Compare the round trip latency of a serial port in default and low latency mode, or measure the in-memory
+  // simulator as a baseline
+  // Usage: serial_latency [port [baudrate]]
+  if (argc < 2)
+  {
+    auto [fc, client] = mspfci::LoopbackTransport::pair();
+    mspfci::Simulator sim(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR), std::move(fc));
+    benchmark(std::move(client), "simulator");
+    return 0;
+  }
+
+  const std::string port = argv[1];
+  const uint32_t baudrate = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 115200;
+
+  benchmark(std::make_unique<mspfci::SerialTransport>(port, baudrate), "default");
+
+  auto transport = std::make_unique<mspfci::SerialTransport>(port, baudrate, true);
+  std::cout << "ASYNC_LOW_LATENCY " << (transport->getLowLatency().async_low_latency ? "set" : "not supported")
+            << std::endl;
+  benchmark(std::move(transport), "low latency");
+
+  return 0;
+}
\ No newline at end of file
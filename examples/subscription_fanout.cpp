@@ -0,0 +1,50 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+int main(int, char**)
+{
+  // Subscribe several times to the same message at different rates, against the in-memory simulator, and compare the
+  // requests served with the messages delivered
+  auto [fc, client] = mspfci::LoopbackTransport::pair();
+  mspfci::Simulator sim(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR), std::move(fc));
+  mspfci::Interface inter(std::move(client), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  // Background traffic (e.g. the RC stream), measured before subscribing
+  const double duration = 2.0;
+  const uint64_t idle_start = sim.getRequests();
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  const uint64_t background = sim.getRequests() - idle_start;
+
+  // Three subscriptions to the IMU, at 200 Hz, 100 Hz and 50 Hz
+  const float freqs[] = {200.0f, 100.0f, 50.0f};
+  std::atomic<uint64_t> delivered[3] = {0, 0, 0};
+  size_t ids[3];
+  ids[0] = inter.subscribe<mspfci::Imu>(freqs[0], [&delivered](const mspfci::Imu&) { ++delivered[0]; });
+  ids[1] = inter.subscribe<mspfci::Imu>(freqs[1], [&delivered](const mspfci::Imu&) { ++delivered[1]; });
+  ids[2] = inter.registerCallback<mspfci::Imu>(50.0f, [&delivered](const mspfci::Msg&) { ++delivered[2]; });
+
+  const uint64_t start = sim.getRequests();
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  const uint64_t requests = sim.getRequests() - start - background;
+  for (const size_t& id : ids)
+  {
+    [[maybe_unused]] const bool succeeded = inter.unsubscribe(id);
+  }
+
+  // The message is requested once for all the subscriptions, at the highest frequency
+  uint64_t total = 0;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    std::cout << "subscription at " << freqs[i] << " Hz: " << delivered[i] / duration << " msg/s" << std::endl;
+    total += delivered[i];
+  }
+  std::cout << "requests: " << requests / duration << " msg/s, deliveries: " << total / duration << " msg/s"
+            << std::endl;
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "mspfci/interface.hpp"
+#include "mspfci/simulator.hpp"
+
+int main(int, char**)
+{
+  // Measure the jitter of a running subscription while other subscriptions are added, paused, resumed, retuned and
+  // removed, against the in-memory simulator
+  auto [fc, client] = mspfci::LoopbackTransport::pair();
+  mspfci::Simulator sim(std::make_shared<mspfci::Logger>(mspfci::LoggerLevel::ERR), std::move(fc));
+  mspfci::Interface inter(std::move(client), mspfci::MSPVer::MSPv1, mspfci::LoggerLevel::ERR);
+
+  // Reference stream at 200 Hz, timestamping each message
+  const auto period = std::chrono::milliseconds(5);
+  std::vector<std::chrono::steady_clock::time_point> stamps(4096);
+  std::atomic<size_t> received = 0;
+  const size_t reference = inter.subscribe<mspfci::Imu>(200.0, [&stamps, &received](const mspfci::Imu&) {
+    const size_t i = received.load();
+    if (i < stamps.size())
+    {
+      stamps[i] = std::chrono::steady_clock::now();
+      received = i + 1;
+    }
+  });
+
+  // Phases, each one repeating an operation on other subscriptions
+  std::vector<std::pair<std::string, std::chrono::steady_clock::time_point>> phases;
+  const auto phase = [&phases](const std::string& name) { phases.emplace_back(name, std::chrono::steady_clock::now()); };
+  const auto wait = []() { std::this_thread::sleep_for(std::chrono::milliseconds(10)); };
+  std::vector<size_t> others;
+
+  phase("idle");
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  phase("add");
+  for (size_t i = 0; i < 50; ++i)
+  {
+    others.push_back(inter.subscribe<mspfci::Altitude>(100.0, [](const mspfci::Altitude&) {}));
+    wait();
+  }
+  phase("pause");
+  for (const size_t& id : others)
+  {
+    [[maybe_unused]] const bool succeeded = inter.pauseSubscription(id);
+    wait();
+  }
+  phase("resume");
+  for (const size_t& id : others)
+  {
+    [[maybe_unused]] const bool succeeded = inter.resumeSubscription(id);
+    wait();
+  }
+  phase("retune");
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    [[maybe_unused]] const bool succeeded = inter.setSubscriptionFrequency(others[i], 50.0f + 10.0f * (i % 10));
+    wait();
+  }
+  phase("remove");
+  for (const size_t& id : others)
+  {
+    [[maybe_unused]] const bool succeeded = inter.unsubscribe(id);
+    wait();
+  }
+  phase("end");
+  [[maybe_unused]] const bool succeeded = inter.unsubscribe(reference);
+
+  // Deviation of the intervals of the reference stream from its period, by phase
+  const size_t n = received;
+  for (size_t p = 0; p + 1 < phases.size(); ++p)
+  {
+    std::chrono::nanoseconds max = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+    size_t count = 0;
+    for (size_t i = 1; i < n; ++i)
+    {
+      if (stamps[i] < phases[p].second || stamps[i] >= phases[p + 1].second)
+      {
+        continue;
+      }
+      const std::chrono::nanoseconds interval = stamps[i] - stamps[i - 1];
+      const std::chrono::nanoseconds deviation = interval > period ? interval - period : period - interval;
+      max = std::max(max, deviation);
+      total += deviation;
+      ++count;
+    }
+    std::cout << phases[p].first << ": " << count << " messages, jitter mean "
+              << (count ? std::chrono::duration<double, std::micro>(total).count() / count : 0.0) << " us, max "
+              << std::chrono::duration<double, std::micro>(max).count() << " us" << std::endl;
+  }
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef CONFIG_MANAGER_H
+#define CONFIG_MANAGER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+#include "mspfci/engine.hpp"
+
+namespace mspfci
+{
+/// Settings, raw values (little endian, as stored by the firmware) by name
+using Settings = std::map<std::string, Bytes>;
+
+/**
+ * @brief Configuration snapshot and restore, through MSP2_COMMON_SETTING and MSP2_COMMON_SET_SETTING.
+ *
+ * All the settings of a snapshot or a restore are queued at once on the I/O engine, which pipelines them, instead of
+ * one round trip per setting. A restore only writes the settings differing from the desired ones, verifies them, and
+ * commits them with a single MSP_EEPROM_WRITE.
+ *
+ * Settings files are text files, with one setting per line: its name and its raw value in hexadecimal, separated
+ * by a space. Empty lines and lines starting with '#' are ignored.
+ */
+class ConfigManager
+{
+ public:
+  /**
+   * @brief Constructor
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   * @param engine Pointer to I/O engine (std::shared_ptr<Engine>)
+   */
+  ConfigManager(std::shared_ptr<Logger> logger, std::shared_ptr<Engine> engine);
+
+  /**
+   * @brief Read settings
+   * @param names (const reference to std::vector<std::string>)
+   * @param settings read settings (reference to Settings)
+   * @return True if all the settings have been read, False otherwise (bool)
+   */
+  [[nodiscard]] bool snapshot(const std::vector<std::string>& names, Settings& settings);
+
+  /**
+   * @brief Write settings, without committing them
+   * @param settings (const reference to Settings)
+   * @return True if all the settings have been written, False otherwise (bool)
+   */
+  [[nodiscard]] bool apply(const Settings& settings);
+
+  /**
+   * @brief Commit the settings to the EEPROM
+   * @return True if the settings have been committed, False otherwise (bool)
+   */
+  [[nodiscard]] bool commit();
+
+  /**
+   * @brief Restore the desired settings: read them, write the ones differing, verify them and commit them. Nothing
+   * is written if the settings are already the desired ones
+   * @param desired (const reference to Settings)
+   * @param changed settings written, if not null (pointer to Settings)
+   * @return True if the settings are the desired ones, False otherwise (bool)
+   */
+  [[nodiscard]] bool restore(const Settings& desired, Settings* changed = nullptr);
+
+  /**
+   * @brief Get the settings differing from the desired ones
+   * @param current (const reference to Settings)
+   * @param desired (const reference to Settings)
+   * @return desired settings differing from, or missing in, the current ones (Settings)
+   */
+  static Settings diff(const Settings& current, const Settings& desired);
+
+  /**
+   * @brief Encode a setting value
+   * @tparam T integral type of the setting
+   * @param x value (const reference to T)
+   * @return raw value (Bytes)
+   */
+  template <typename T>
+  static Bytes value(const T& x)
+  {
+    Bytes data;
+    [[maybe_unused]] const bool succeeded = encode(x, data);
+    return data;
+  }
+
+  /**
+   * @brief Save settings to a file
+   * @param path (const reference to std::string)
+   * @param settings (const reference to Settings)
+   * @return True if the settings have been saved, False otherwise (bool)
+   */
+  [[nodiscard]] static bool save(const std::string& path, const Settings& settings);
+
+  /**
+   * @brief Load settings from a file
+   * @param path (const reference to std::string)
+   * @param settings loaded settings (reference to Settings)
+   * @return True if the settings have been loaded, False otherwise (bool)
+   */
+  [[nodiscard]] static bool load(const std::string& path, Settings& settings);
+
+ private:
+  /**
+   * @brief Queue requests of the same code at once, and wait for all their responses
+   * @param code (const reference to MSPCode)
+   * @param requests payloads (const reference to std::vector<Bytes>)
+   * @param responses received data, empty for the failed requests (reference to std::vector<Bytes>)
+   * @return True if all the requests succeeded, False otherwise (bool)
+   */
+  [[nodiscard]] bool transact(const MSPCode& code, const std::vector<Bytes>& requests, std::vector<Bytes>& responses);
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_;
+
+  /// Shared pointer to the I/O engine
+  std::shared_ptr<Engine> engine_;
+};
+}  // namespace mspfci
+
+#endif  // CONFIG_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,181 @@
+#ifndef DATAFLASH_H
+#define DATAFLASH_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "logger.hpp"
+#include "mspfci/engine.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Progress of a dataflash download
+ */
+struct DownloadProgress
+{
+  /// Number of bytes stored, including the ones resumed from a previous download
+  uint64_t stored = 0;
+
+  /// Number of bytes stored, and received before decompression, by this download
+  uint64_t downloaded = 0;
+  uint64_t received = 0;
+
+  /// Number of bytes to be stored in total
+  uint64_t total = 0;
+
+  /// Time elapsed since the beginning of the download
+  std::chrono::nanoseconds elapsed = std::chrono::nanoseconds::zero();
+
+  /**
+   * @brief Get the throughput of this download, in stored bytes per second
+   * @return throughput (double)
+   */
+  inline double throughput() const
+  {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0.0 ? static_cast<double>(downloaded) / seconds : 0.0;
+  }
+};
+
+/**
+ * @brief Bulk download of the onboard flash (blackbox logs), through MSP_DATAFLASH_SUMMARY and MSP_DATAFLASH_READ.
+ *
+ * Up to window read requests are kept in flight on the I/O engine, which pipelines them, so that the link is kept
+ * busy instead of idling for a round trip per chunk. The chunks are streamed to a file in order as they complete.
+ * Short reads are completed by requesting the remainder, and failed reads are retried. The file only ever holds
+ * the contiguous beginning of the flash, hence a failed download is resumed from its size, once its last chunk has
+ * been checked against the flash (it is downloaded again if the flash has been erased since).
+ *
+ * Compression by the firmware is only requested when a decompressor is set, the decoding of the firmware compression
+ * (e.g. the static Huffman table of Betaflight) being up to the caller.
+ */
+class DataflashDownloader
+{
+ public:
+  /// Progress callback, called on the downloading thread each time chunks are stored
+  using ProgressCallback = std::function<void(const DownloadProgress&)>;
+
+  /// Decompressor, called with the compression type and the compressed data, returning the decompressed data
+  using Decompressor = std::function<bool(const uint8_t&, const Bytes&, Bytes&)>;
+
+  /**
+   * @brief Constructor
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   * @param engine Pointer to I/O engine (std::shared_ptr<Engine>)
+   */
+  DataflashDownloader(std::shared_ptr<Logger> logger, std::shared_ptr<Engine> engine);
+
+  /**
+   * @brief Download the used part of the flash to a file, blocking until complete or failed
+   * @param path (const reference to std::string)
+   * @param progress (ProgressCallback)
+   * @param resume (const reference to bool) true to resume from the size of an existing file still
+   * matching the flash, false to start over
+   * @return True if the whole flash has been downloaded, False otherwise (bool)
+   */
+  [[nodiscard]] bool download(const std::string& path, ProgressCallback progress = nullptr, const bool& resume = true);
+
+  /**
+   * @brief Setter. Set the size requested by each read, the flight controller may answer less
+   * @param size (const reference to uint16_t)
+   */
+  inline void setChunkSize(const uint16_t& size) { chunk_size_ = std::max<uint16_t>(size, 1); }
+
+  /**
+   * @brief Setter. Set the maximum number of reads in flight
+   * @param window (const reference to size_t)
+   */
+  inline void setWindow(const size_t& window) { window_ = std::max<size_t>(window, 1); }
+
+  /**
+   * @brief Setter. Set the number of retries of a failed read, before the download fails
+   * @param retries (const reference to size_t)
+   */
+  inline void setRetries(const size_t& retries) { retries_ = retries; }
+
+  /**
+   * @brief Setter. Set the decompressor, enabling the compression by the firmware (nullptr to disable it)
+   * @param decompressor (Decompressor)
+   */
+  inline void setDecompressor(Decompressor decompressor) { decompressor_ = std::move(decompressor); }
+
+ private:
+  /**
+   * @brief Read of a range of the flash
+   */
+  struct Read
+  {
+    uint32_t address;
+    uint16_t size;
+    size_t attempts;
+  };
+
+  /**
+   * @brief Completed read
+   */
+  struct Completion
+  {
+    Read read;
+    bool succeeded;
+    Bytes data;
+  };
+
+  /**
+   * @brief Submit a read to the I/O engine, completed into the completion queue
+   * @param read (const reference to Read)
+   */
+  void submit(const Read& read);
+
+  /**
+   * @brief Wait for a read to complete
+   * @return completed read (Completion)
+   */
+  Completion waitCompletion();
+
+  /**
+   * @brief Read a range of the flash, one read at a time, blocking until complete or failed
+   * @param address (const reference to uint32_t)
+   * @param size (const reference to uint32_t)
+   * @param data (reference to Bytes)
+   * @return True if the whole range has been read, False otherwise (bool)
+   */
+  [[nodiscard]] bool readRange(const uint32_t& address, const uint32_t& size, Bytes& data);
+
+  /**
+   * @brief Decode the response to a read
+   * @param read (const reference to Read)
+   * @param response (const reference to Bytes)
+   * @param data decoded data (reference to Bytes)
+   * @param received size of the response payload (reference to size_t)
+   * @return True if the response answers the read, False otherwise (bool)
+   */
+  [[nodiscard]] bool decodeRead(const Read& read, const Bytes& response, Bytes& data, size_t& received);
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_;
+
+  /// Shared pointer to the I/O engine
+  std::shared_ptr<Engine> engine_;
+
+  /// Settings
+  uint16_t chunk_size_ = 4096;
+  size_t window_ = 4;
+  size_t retries_ = 5;
+  Decompressor decompressor_ = nullptr;
+
+  /// Completed reads, protected by mutex
+  std::deque<Completion> completions_;
+  std::mutex completions_mtx_;
+  std::condition_variable completions_cv_;
+};
+}  // namespace mspfci
+
+#endif  // DATAFLASH_H
\ No newline at end of file
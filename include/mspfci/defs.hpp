@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <type_traits>
+#include <vector>
 
 namespace mspfci
 {
@@ -28,11 +29,19 @@ enum class MSPVer : int
  */
 enum class MSPCode : uint16_t
 {
+  MSP_API_VERSION = 1,
+  MSP_FC_VERSION = 3,
   MSP_RX_MAP = 64,
+  MSP_DATAFLASH_SUMMARY = 70,
+  MSP_DATAFLASH_READ = 71,
   MSP_RAW_IMU = 102,
   MSP_ALTITUDE = 109,
   MSP_RC = 105,
+  MSP_UID = 160,
   MSP_SET_RAW_RC = 200,
+  MSP_EEPROM_WRITE = 250,
+  MSP2_COMMON_SETTING = 0x1003,
+  MSP2_COMMON_SET_SETTING = 0x1004,
 
 };
 }  // namespace mspfci
@@ -0,0 +1,293 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "logger.hpp"
+#include "mspfci/msp.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Priority classes of the requests, served in strict priority order
+ */
+enum class Priority : size_t
+{
+  CONTROL = 0,
+  TELEMETRY = 1,
+};
+
+/**
+ * @brief Latency statistics, from the submission of a request to its frame being written
+ */
+struct LatencyStats
+{
+  /// Number of samples
+  uint64_t count = 0;
+
+  /// Worst case and cumulative latency
+  std::chrono::nanoseconds max = std::chrono::nanoseconds::zero();
+  std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+
+  /**
+   * @brief Add a sample
+   * @param latency (const reference to std::chrono::nanoseconds)
+   */
+  inline void add(const std::chrono::nanoseconds& latency)
+  {
+    ++count;
+    total += latency;
+    max = std::max(max, latency);
+  }
+
+  /**
+   * @brief Get the mean latency
+   * @return mean latency (std::chrono::nanoseconds)
+   */
+  inline std::chrono::nanoseconds mean() const
+  {
+    return count == 0 ? std::chrono::nanoseconds::zero() : total / static_cast<int64_t>(count);
+  }
+};
+
+/**
+ * @brief Acknowledgment statistics of the requests written without waiting for their response (e.g. MSP_SET_RAW_RC,
+ * answered with an empty frame)
+ */
+struct AckStats
+{
+  /// Number of acknowledgments awaited
+  uint64_t pending = 0;
+
+  /// Number of acknowledgments received, and lost (not received within the timeout)
+  uint64_t received = 0;
+  uint64_t lost = 0;
+
+  /// Number of discarded frames answering no request
+  uint64_t unexpected = 0;
+};
+
+/**
+ * @brief I/O engine. Serve queued MSP requests on a single thread, and complete them through a callback.
+ *
+ * Requests are queued in lanes by priority, and at each frame boundary the highest priority request is served.
+ * While waiting for a response, queued CONTROL requests not expecting a response are written right away, so that
+ * commands are never delayed by a telemetry round trip. Up to max_pipeline queued requests expecting a response are
+ * pipelined, written back to back before their responses are received.
+ *
+ * The acknowledgments of the requests written without waiting for their response are collected as they arrive, and
+ * matched by code in order of writing, so that a response is only ever completed with a frame of its own code.
+ */
+class Engine
+{
+ public:
+  /// Completion callback, called on the engine thread with the outcome of the request and the received data
+  using Callback = std::function<void(const bool&, const Bytes&)>;
+
+  /**
+   * @brief Construct a new Engine object and start it
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   * @param msp Pointer to msp (std::shared_ptr<MSP>)
+   */
+  Engine(std::shared_ptr<Logger> logger, std::shared_ptr<MSP> msp);
+
+  /**
+   * @brief Copy constructor
+   */
+  Engine(const Engine& other) = delete;
+
+  /**
+   * @brief Assignment operator overloading
+   * @param other (const reference to Engine)
+   * @return Engine&
+   */
+  Engine& operator=(const Engine& other) = delete;
+
+  /**
+   * @brief Destroy the Engine object, pending requests are completed as failed
+   */
+  ~Engine();
+
+  /**
+   * @brief Queue a request
+   * @param code (const reference to MSPCode)
+   * @param data request payload (Bytes)
+   * @param callback completion callback (Callback)
+   * @param priority (const reference to Priority)
+   * @param response (const reference to bool) true if a response has to be received, false to complete the request
+   * as soon as it is written
+   */
+  void submit(const MSPCode& code,
+              Bytes data,
+              Callback callback,
+              const Priority& priority = Priority::TELEMETRY,
+              const bool& response = true);
+
+  /**
+   * @brief Queue a request and wait for its response
+   * @param code (const reference to MSPCode)
+   * @param data request payload (const reference to Bytes)
+   * @param response received data (reference to Bytes)
+   * @param priority (const reference to Priority)
+   * @return True if the round trip succeeded, False otherwise (bool)
+   */
+  [[nodiscard]] bool request(const MSPCode& code,
+                             const Bytes& data,
+                             Bytes& response,
+                             const Priority& priority = Priority::TELEMETRY);
+
+  /**
+   * @brief Queue a command, and wait for it to be written (fire and forget, its acknowledgment is accounted once
+   * received) or acknowledged
+   * @param code (const reference to MSPCode)
+   * @param data request payload (const reference to Bytes)
+   * @param priority (const reference to Priority)
+   * @param ack (const reference to bool) true to wait for the acknowledgment, false to only wait for the writing
+   * @return True if the request was written, or acknowledged, False otherwise (bool)
+   */
+  [[nodiscard]] bool send(const MSPCode& code,
+                          const Bytes& data,
+                          const Priority& priority = Priority::CONTROL,
+                          const bool& ack = false);
+
+  /**
+   * @brief Getter. Get the latency statistics of a priority class
+   * @param priority (const reference to Priority)
+   * @return latency statistics (LatencyStats)
+   */
+  LatencyStats getLatency(const Priority& priority);
+
+  /**
+   * @brief Getter. Get the acknowledgment statistics
+   * @return acknowledgment statistics (AckStats)
+   */
+  AckStats getAcks();
+
+  /**
+   * @brief Getter. Get the number of received frames dropped because of a checksum mismatch, as of the last batch
+   * @return number of frames (uint64_t)
+   */
+  inline uint64_t getCrcErrors() const { return crc_errors_; }
+
+  /**
+   * @brief Getter. Get the native handle of the engine thread
+   * @return native handle (std::thread::native_handle_type)
+   */
+  inline std::thread::native_handle_type getNativeHandle() { return th_.native_handle(); }
+
+ private:
+  /**
+   * @brief Queued request
+   */
+  struct Request
+  {
+    MSPCode code;
+    Bytes data;
+    Callback callback;
+    Priority priority;
+    bool response;
+    std::chrono::steady_clock::time_point submitted;
+  };
+
+  /**
+   * @brief Pop the highest priority request, the queue mutex must be held
+   * @param request (reference to Request)
+   * @return True if a request was popped, False otherwise (bool)
+   */
+  [[nodiscard]] bool pop(Request& request);
+
+  /**
+   * @brief Write a request, the MSP mutex must be held
+   * @param request (const reference to Request)
+   * @return True if the request was written, False otherwise (bool)
+   */
+  [[nodiscard]] bool write(const Request& request);
+
+  /**
+   * @brief Check if the next request to be popped expects a response, the queue mutex must be held
+   * @return True if the next request expects a response, False otherwise (bool)
+   */
+  [[nodiscard]] bool nextExpectsResponse() const;
+
+  /**
+   * @brief Send the batch of requests back to back and receive their responses in order, writing queued CONTROL
+   * requests while waiting. The outcomes are stored in succeeded_ and responses_
+   */
+  void transact();
+
+  /**
+   * @brief Write all the queued CONTROL requests not expecting a response
+   */
+  void preempt();
+
+  /**
+   * @brief Account a received frame as the acknowledgment of the first awaited one of the same code, if written
+   * before the given time. The acknowledgments awaited before it are accounted as lost
+   * @param code (const reference to MSPCode)
+   * @param before (const reference to std::chrono::steady_clock::time_point)
+   * @return True if the frame has been accounted as an acknowledgment, False otherwise (bool)
+   */
+  bool acknowledge(const MSPCode& code,
+                   const std::chrono::steady_clock::time_point& before = std::chrono::steady_clock::time_point::max());
+
+  /**
+   * @brief Receive the acknowledgments already available, and account the expired ones as lost, the MSP mutex must
+   * be held
+   */
+  void collectAcks();
+
+  /// Number of priority classes
+  static constexpr size_t priorities_ = 2;
+
+  /// Maximum number of requests in flight
+  static constexpr size_t max_pipeline = 4;
+
+  /// Batch of requests being served, and their outcomes, reused across batches
+  std::vector<Request> batch_;
+  std::array<bool, max_pipeline> succeeded_;
+  std::array<Bytes, max_pipeline> responses_;
+
+  /// Thread where the engine is running
+  std::thread th_;
+
+  /// Flag to indicate wheater the engine is active
+  std::atomic_bool active_ = true;
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_ = nullptr;
+
+  /// Shared pointer to MSP
+  std::shared_ptr<MSP> msp_ = nullptr;
+
+  /// Queued requests by priority, protected by mutex
+  std::array<std::deque<Request>, priorities_> lanes_;
+  std::mutex queue_mtx_;
+  std::condition_variable queue_cv_;
+
+  /// Number of queued CONTROL requests not expecting a response
+  std::atomic<size_t> preemptible_ = 0;
+
+  /// Acknowledgments awaited in order of writing, with their time of writing, and statistics, protected by mutex
+  std::deque<std::pair<MSPCode, std::chrono::steady_clock::time_point>> acks_;
+  AckStats ack_stats_;
+  std::mutex ack_mtx_;
+
+  /// Number of CRC errors of the MSP link, updated after each batch
+  std::atomic<uint64_t> crc_errors_ = 0;
+
+  /// Latency statistics by priority, protected by mutex
+  std::array<LatencyStats, priorities_> latency_;
+  std::mutex latency_mtx_;
+};
+}  // namespace mspfci
+
+#endif  // ENGINE_H
\ No newline at end of file
@@ -0,0 +1,185 @@
+#ifndef FLEET_MANAGER_H
+#define FLEET_MANAGER_H
+
+#include <serial/serial.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+#include "mspfci/engine.hpp"
+#include "mspfci/msgs.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Statistics of a flight controller of the fleet
+ */
+struct FleetStats
+{
+  /// Requests written, and responses received
+  uint64_t requests = 0;
+  uint64_t responses = 0;
+
+  /// Requests with no response within the timeout, error responses, and responses failing to decode
+  uint64_t timeouts = 0;
+  uint64_t errors = 0;
+  uint64_t decode_errors = 0;
+
+  /// Frames dropped because of a checksum mismatch, and frames discarded as not matching the request in flight
+  /// (e.g. acks of commands)
+  uint64_t crc_errors = 0;
+  uint64_t discarded = 0;
+
+  /// Round trip latency, from the request being written to its response being received
+  LatencyStats latency;
+};
+
+/**
+ * @brief Manager of a fleet of flight controllers, driven by a small fixed pool of epoll event loops.
+ *
+ * Each flight controller is assigned to one of the loops, which polls its subscriptions, writes the requests and
+ * parses the responses incrementally, without any thread per port or per subscription. A loop serves one request at
+ * a time per flight controller, and the requests of different flight controllers are all in flight concurrently.
+ * The messages per second scale with the number of loops, as long as each loop gets a core of its own.
+ */
+class FleetManager
+{
+ public:
+  /// Subscription callback, called on the loop thread with the index of the flight controller and the message
+  using Callback = std::function<void(const size_t&, const Msg&)>;
+
+  /**
+   * @brief Constructor, start the event loops
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   * @param loops number of event loops (const reference to size_t)
+   * @param pin pin the event loop i to the core i (const reference to bool)
+   */
+  FleetManager(std::shared_ptr<Logger> logger, const size_t& loops = 1, const bool& pin = false);
+
+  /**
+   * @brief Destructor, stop the event loops and close the ports
+   */
+  ~FleetManager();
+
+  /**
+   * @brief Open a serial port and add its flight controller to the fleet
+   * @param port (const reference to std::string)
+   * @param baudrate (const reference to uint32_t)
+   * @param ver (const reference to MSPVer)
+   * @return index of the flight controller (size_t)
+   */
+  size_t add(const std::string& port, const uint32_t& baudrate = 115200, const MSPVer& ver = MSPVer::MSPv1);
+
+  /**
+   * @brief Add the flight controller behind an already open file descriptor (e.g. a socket) to the fleet. The file
+   * descriptor is set non-blocking, and is not closed by the fleet manager
+   * @param fd (int)
+   * @param ver (const reference to MSPVer)
+   * @return index of the flight controller (size_t)
+   */
+  size_t add(int fd, const MSPVer& ver = MSPVer::MSPv1);
+
+  /**
+   * @brief Subscribe to a message of a flight controller, requested at the given frequency. The callback is called
+   * on the loop thread and must not block
+   *
+   * @tparam Message type
+   * @param fc index of the flight controller (const reference to size_t)
+   * @param freq frequency (float)
+   * @param callback (Callback)
+   * @return true if subscribed, false if the frequency is not positive (bool)
+   */
+  template <typename T>
+  [[nodiscard]] inline bool subscribe(const size_t& fc, float freq, Callback callback)
+  {
+    return subscribe(fc, freq, std::move(callback), std::make_unique<T>());
+  }
+
+  /**
+   * @brief Send a command to a flight controller, without waiting for its acknowledgement (discarded when received)
+   * @param fc index of the flight controller (const reference to size_t)
+   * @param code (const reference to MSPCode)
+   * @param data (const reference to Bytes)
+   * @return True if the command was queued for writing, False otherwise (bool)
+   */
+  [[nodiscard]] bool send(const size_t& fc, const MSPCode& code, const Bytes& data);
+
+  /**
+   * @brief Check if the port of a flight controller is open
+   * @param fc index of the flight controller (const reference to size_t)
+   * @return True if the port is open, False otherwise (bool)
+   */
+  bool isOpen(const size_t& fc);
+
+  /**
+   * @brief Getter. Get the statistics of a flight controller
+   * @param fc index of the flight controller (const reference to size_t)
+   * @return statistics (FleetStats)
+   */
+  FleetStats getStats(const size_t& fc);
+
+  /**
+   * @brief Getter. Get the number of flight controllers in the fleet
+   * @return number of flight controllers (size_t)
+   */
+  size_t size();
+
+  /**
+   * @brief Setter. Set the response timeout, for the flight controllers added afterwards
+   * @param timeout (const reference to std::chrono::nanoseconds)
+   */
+  inline void setTimeout(const std::chrono::nanoseconds& timeout) { timeout_ = timeout; }
+
+ private:
+  /// Subscription, flight controller, and event loop, defined in the source
+  struct Subscription;
+  struct Controller;
+  class Loop;
+
+  /**
+   * @brief Add a flight controller to the next loop
+   * @param fd (int)
+   * @param serial serial port owned by the flight controller, if any (std::unique_ptr<serial::Serial>)
+   * @param ver (const reference to MSPVer)
+   * @return index of the flight controller (size_t)
+   */
+  size_t add(int fd, std::unique_ptr<serial::Serial> serial, const MSPVer& ver);
+
+  /**
+   * @brief Subscribe to a message of a flight controller
+   * @param fc index of the flight controller (const reference to size_t)
+   * @param freq frequency (float)
+   * @param callback (Callback)
+   * @param msg message to be decoded (std::unique_ptr<Msg>)
+   * @return true if subscribed, false if the frequency is not valid (bool)
+   */
+  [[nodiscard]] bool subscribe(const size_t& fc, float freq, Callback callback, std::unique_ptr<Msg> msg);
+
+  /**
+   * @brief Get the loop and the flight controller of an index
+   * @param fc index of the flight controller (const reference to size_t)
+   * @return loop and flight controller (std::pair<Loop*, Controller*>)
+   */
+  std::pair<Loop*, Controller*> find(const size_t& fc);
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_;
+
+  /// Event loops
+  std::vector<std::unique_ptr<Loop>> loops_;
+
+  /// Flight controllers and their loop, by index, protected by mutex
+  std::vector<std::pair<Loop*, Controller*>> fcs_;
+  std::mutex fcs_mtx_;
+
+  /// Response timeout
+  std::chrono::nanoseconds timeout_ = std::chrono::milliseconds(100);
+};
+}  // namespace mspfci
+
+#endif  // FLEET_MANAGER_H
\ No newline at end of file
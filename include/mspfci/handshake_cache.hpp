@@ -0,0 +1,82 @@
+#ifndef HANDSHAKE_CACHE_H
+#define HANDSHAKE_CACHE_H
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "logger.hpp"
+#include "mspfci/defs.hpp"
+#include "mspfci/msgs.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief On-disk cache of the handshake responses (RX map, RC channels, API version...), one file per board, named
+ * after the unique id of its MCU. An entry is valid only for the firmware version it was written for, and only if
+ * its checksum matches, so that a reflashed board or a corrupted file are queried again.
+ *
+ * File format (little endian): "MSPH" magic, format version (uint8_t), firmware major, minor and patch versions
+ * (uint8_t), followed by records made of the MSP code (uint16_t), the payload size (uint16_t) and the payload itself,
+ * closed by the CRC8 DVB-S2 of all the previous bytes.
+ */
+class HandshakeCache
+{
+ public:
+  /**
+   * @brief Constructor
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   * @param directory directory of the cache files, created when first written (const reference to std::string)
+   */
+  HandshakeCache(std::shared_ptr<Logger> logger, const std::string& directory);
+
+  /**
+   * @brief Load the entry of a board, replacing the current one
+   * @param uid unique id of the board (const reference to BoardUid)
+   * @param version firmware version of the board (const reference to FcVersion)
+   * @return True if a valid entry has been loaded, False otherwise (bool)
+   */
+  [[nodiscard]] bool load(const BoardUid& uid, const FcVersion& version);
+
+  /**
+   * @brief Store the current entry for a board, atomically replacing the previous file
+   * @param uid unique id of the board (const reference to BoardUid)
+   * @param version firmware version of the board (const reference to FcVersion)
+   * @return True if the entry has been stored, False otherwise (bool)
+   */
+  [[nodiscard]] bool store(const BoardUid& uid, const FcVersion& version);
+
+  /**
+   * @brief Get a cached message
+   * @param msg message to be decoded from the cached payload of its code (reference to Msg)
+   * @return True if the message is cached and decoded, False otherwise (bool)
+   */
+  [[nodiscard]] bool get(Msg& msg) const;
+
+  /**
+   * @brief Set a message in the current entry
+   * @param msg message to be encoded (reference to Msg)
+   * @return True if the message has been encoded, False otherwise (bool)
+   */
+  [[nodiscard]] bool set(Msg& msg);
+
+ private:
+  /**
+   * @brief Get the path of the file of a board
+   * @param uid unique id of the board (const reference to BoardUid)
+   * @return path (std::string)
+   */
+  std::string path(const BoardUid& uid) const;
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_;
+
+  /// Directory of the cache files
+  std::string directory_;
+
+  /// Payloads of the current entry, by code
+  std::map<MSPCode, Bytes> payloads_;
+};
+}  // namespace mspfci
+
+#endif  // HANDSHAKE_CACHE_H
\ No newline at end of file
@@ -1,15 +1,34 @@
 #ifndef INTERFACE_H
 #define INTERFACE_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <future>
+#include <limits>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
 
 #include "logger.hpp"
+#include "mspfci/config_manager.hpp"
+#include "mspfci/dataflash.hpp"
+#include "mspfci/engine.hpp"
+#include "mspfci/handshake_cache.hpp"
 #include "mspfci/msp.hpp"
 #include "mspfci/periodic_callback.hpp"
+#include "mspfci/port_watcher.hpp"
+#include "mspfci/rc_stream.hpp"
+#include "mspfci/read_awaitable.hpp"
+#include "mspfci/realtime.hpp"
 #include "utils.hpp"
 
 namespace mspfci
@@ -20,6 +39,9 @@ namespace mspfci
 class Interface
 {
  public:
+  /// Handle returned when a subscription is rejected, matching no subscription
+  static constexpr size_t invalid_subscription = std::numeric_limits<size_t>::max();
+
   /**
    * @brief Constructor of the Interface
    *
@@ -27,11 +49,104 @@ class Interface
    * @param baudrate (const reference to uint32_t)
    * @param ver (const reference to MSPVer)
    * @param level (const reference to LoggerLevel)
+   * @param wait (const reference to bool) true to wait for the initialization to complete, false to return right away
+   * and be notified through getReady() or onReady()
+   * @param cache (const reference to std::string) directory of the handshake cache, empty to disable it. When the
+   * board has a valid entry, the interface is ready as soon as the board is identified, and the handshake is refreshed
+   * in the background
    */
   Interface(const std::string& port,
             const uint32_t& baudrate = 115200,
             const MSPVer& ver = MSPVer::MSPv1,
-            const LoggerLevel& level = LoggerLevel::FULL);
+            const LoggerLevel& level = LoggerLevel::FULL,
+            const bool& wait = true,
+            const std::string& cache = "");
+
+  /**
+   * @brief Constructor of the Interface on a given transport (serial, TCP, UDP, loopback, replay)
+   *
+   * @param transport (std::unique_ptr<Transport>)
+   * @param ver (const reference to MSPVer)
+   * @param level (const reference to LoggerLevel)
+   * @param wait (const reference to bool) true to wait for the initialization to complete, false to return right away
+   * and be notified through getReady() or onReady()
+   * @param cache (const reference to std::string) directory of the handshake cache, empty to disable it. When the
+   * board has a valid entry, the interface is ready as soon as the board is identified, and the handshake is refreshed
+   * in the background
+   */
+  Interface(std::unique_ptr<Transport> transport,
+            const MSPVer& ver = MSPVer::MSPv1,
+            const LoggerLevel& level = LoggerLevel::FULL,
+            const bool& wait = true,
+            const std::string& cache = "");
+
+  /**
+   * @brief Destructor, stop the initialization and stop watching the port
+   */
+  ~Interface();
+
+  /**
+   * @brief Check if the initialization (RX map, RC channels and API version) is complete. Commands fail until then
+   *
+   * @return true if the interface is ready, false otherwise
+   */
+  [[nodiscard]] inline bool isReady() const { return ready_; }
+
+  /**
+   * @brief Get a future, ready once the initialization is complete
+   *
+   * @return future (std::shared_future<void>)
+   */
+  inline std::shared_future<void> getReady() const { return ready_future_; }
+
+  /**
+   * @brief Register a callback called once the initialization is complete, on the initialization thread, or right
+   * away if already complete
+   *
+   * @param callback (std::function<void()>)
+   */
+  void onReady(std::function<void()> callback);
+
+  /**
+   * @brief Get the startup time, from the construction to the initialization being complete. Valid once ready
+   *
+   * @return startup time (std::chrono::nanoseconds)
+   */
+  inline std::chrono::nanoseconds getStartupTime() const { return startup_time_; }
+
+  /**
+   * @brief Get the API version of the flight controller, as queried at startup. Valid once ready, left empty if the
+   * flight controller does not answer it
+   *
+   * @return API version (const reference to ApiVersion)
+   */
+  inline const ApiVersion& getApiVersion() const { return api_version_; }
+
+  /**
+   * @brief Watch the port of the interface for hotplug events. The callback is called on the watcher thread as soon
+   * as the port is removed or added back, and must not block
+   *
+   * @param watcher Pointer to port watcher, possibly shared by several interfaces (std::shared_ptr<PortWatcher>)
+   * @param callback (std::function<void(const PortEvent&)>)
+   */
+  void watchPort(std::shared_ptr<PortWatcher> watcher, std::function<void(const PortEvent&)> callback);
+
+  /**
+   * @brief Enable the automatic reconnection. Once the connection is lost (e.g. the USB device unplugged), the port is
+   * reopened as soon as it is back, retrying with a backoff from 10 ms to 100 ms. The registered callbacks keep
+   * running, the cached RX map is kept, and the RC stream resumes with the last channels
+   *
+   * @param watcher Pointer to port watcher, optional. If given, the port is closed as soon as it is removed, and
+   * reopened as soon as it is added back (std::shared_ptr<PortWatcher>)
+   */
+  void enableReconnect(std::shared_ptr<PortWatcher> watcher = nullptr);
+
+  /**
+   * @brief Get the time to recover statistics, from the connection being lost to it being reopened
+   *
+   * @return recovery time statistics (LatencyStats)
+   */
+  LatencyStats getRecoveryTime();
 
   /**
    * @brief Register a callback function into a periodic callback that will send a message to
@@ -41,13 +156,121 @@ class Interface
    * @tparam Message type
    * @param freq is the frequency the periodic callback has to be ran at (rvalue reference)
    * @param func callback function to be called when a message is received (rvalue reference)
+   * @return handle of the subscription, invalid_subscription if the frequency is not positive (size_t)
    */
   template <typename T>
-  inline void registerCallback(float&& freq, std::function<void(const Msg&)>&& callback)
+  inline size_t registerCallback(float&& freq, std::function<void(const Msg&)>&& callback)
+  {
+    return addSubscription(std::make_unique<T>(),
+                           std::make_unique<TypedSubscriber<std::function<void(const Msg&)>>>(std::move(callback)),
+                           freq);
+  }
+
+  /**
+   * @brief Subscribe to a message, requested from the flight controller at the defined frequency. The callback is
+   * called with each decoded message, as its concrete type. The callable is kept with its own type, without a
+   * std::function nor its possible allocation, and is called directly (possibly inlined) by the delivery of the
+   * subscription, a single virtual call per message. The subscriptions to the same message are merged: the message
+   * is requested once at the highest frequency, decoded once, and delivered to each subscription at its own
+   * frequency
+   *
+   * @tparam T Message type
+   * @tparam F Callback type, callable with a const reference to T
+   * @param freq is the frequency the message is requested at
+   * @param callback callback function to be called when a message is received
+   * @return handle of the subscription, invalid_subscription if the frequency is not positive (size_t)
+   */
+  template <typename T, typename F>
+  inline size_t subscribe(float freq, F&& callback)
   {
-    pcs_.emplace_back(logger_, msp_, std::move(freq), std::move(callback), std::make_unique<T>());
+    static_assert(std::is_base_of_v<Msg, T>, "T must be a message");
+    static_assert(std::is_invocable_v<std::decay_t<F>&, const T&>, "The callback must be callable with const T&");
+    return addSubscription(
+        std::make_unique<T>(),
+        std::make_unique<TypedSubscriber<std::decay_t<F>, T>>(std::decay_t<F>(std::forward<F>(callback))), freq);
   }
 
+  /**
+   * @brief Remove a subscription, waiting for the delivery in progress (if any) to complete. The other subscriptions
+   * keep running undisturbed. Must not be called from a callback of the same message
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @return true if the subscription was removed, false if there is no such subscription
+   */
+  bool unsubscribe(const size_t& id);
+
+  /**
+   * @brief Pause a subscription, its request in flight (if any) still completes
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @return true if the subscription was paused, false if there is no such subscription
+   */
+  bool pauseSubscription(const size_t& id);
+
+  /**
+   * @brief Resume a paused subscription, its next request is sent right away
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @return true if the subscription was resumed, false if there is no such subscription
+   */
+  bool resumeSubscription(const size_t& id);
+
+  /**
+   * @brief Change the frequency of a subscription, its next request is rescheduled from the start of the last one
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @param freq frequency (float)
+   * @return true if the frequency was changed, false if there is no such subscription or the frequency is not
+   * positive
+   */
+  bool setSubscriptionFrequency(const size_t& id, float freq);
+
+  /**
+   * @brief Enable the adaptive mode of a subscription: its frequency is adjusted within the range, starting from the
+   * minimum, to the health of the link (round trips, failures and CRC errors). Setting a frequency disables it
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @param min_freq minimum frequency (float)
+   * @param max_freq maximum frequency (float)
+   * @return true if the adaptive mode was enabled, false if there is no such subscription or the range is not
+   * positive (0 < min_freq <= max_freq)
+   */
+  bool setSubscriptionAdaptive(const size_t& id, float min_freq, float max_freq);
+
+  /**
+   * @brief Get the current frequency of a subscription, fixed or adapted
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @return frequency, zero if there is no such subscription (float)
+   */
+  float getSubscriptionFrequency(const size_t& id);
+
+  /**
+   * @brief Get the adaptive mode statistics of a subscription
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @return statistics, empty if there is no such subscription or the adaptive mode is disabled (RateStats)
+   */
+  RateStats getSubscriptionRateStats(const size_t& id);
+
+  /**
+   * @brief Apply a real-time configuration: scheduling policy, priority and affinity of the I/O threads (engine and
+   * RC stream) and of the subscription threads, including the ones subscribed afterwards, and memory locking. The
+   * failures (e.g. missing privileges) are logged, and the rest of the configuration is applied anyway
+   *
+   * @param config (const reference to RealtimeConfig)
+   * @return true if the whole configuration was applied, false otherwise
+   */
+  bool setRealtime(const RealtimeConfig& config);
+
+  /**
+   * @brief Get the jitter statistics of a subscription, the lateness of its requests with respect to their schedule
+   *
+   * @param id handle of the subscription (const reference to size_t)
+   * @return jitter statistics, empty if there is no such subscription (LatencyStats)
+   */
+  LatencyStats getSubscriptionJitter(const size_t& id);
+
   /**
    * @brief Read message. Send request to the flight controller and wait for the response
    *
@@ -57,52 +280,167 @@ class Interface
   [[nodiscard]] bool read(Msg& msg);
 
   /**
-   * @brief Send arm command to the flight controller
+   * @brief Asynchronous read. Queue a request to the I/O engine when awaited, the awaiting coroutine is resumed on
+   * the engine thread with the decoded message (empty if the read failed)
+   *
+   * @tparam Message type
+   * @return awaitable (ReadAwaitable<T>)
+   */
+  template <typename T>
+  [[nodiscard]] inline ReadAwaitable<T> readAsync()
+  {
+    return ReadAwaitable<T>(engine_);
+  }
+
+  /**
+   * @brief Asynchronous read without coroutines. Queue a request to the I/O engine and return a future to the
+   * decoded message (empty if the read failed)
    *
-   * @return true if arming was succesfull, false otherwise
+   * @tparam Message type
+   * @return future (std::future<std::optional<T>>)
+   */
+  template <typename T>
+  [[nodiscard]] std::future<std::optional<T>> readFuture()
+  {
+    auto promise = std::make_shared<std::promise<std::optional<T>>>();
+    auto future = promise->get_future();
+    const MSPCode code = T().getCode();
+    engine_->submit(code, Bytes(), [promise](const bool& succeeded, const Bytes& data) {
+      T msg;
+      if (succeeded && msg.decodeMessage(data))
+      {
+        promise->set_value(std::move(msg));
+      }
+      else
+      {
+        promise->set_value(std::nullopt);
+      }
+    });
+    return future;
+  }
+
+  /**
+   * @brief Send arm command to the flight controller. Non-blocking, the command is sent with the next RC frame
+   *
+   * @return true if arming was succesfull, false otherwise (e.g. the link is down, the command being sent once it is
+   * back)
    */
   [[nodiscard]] bool arm();
 
   /**
-   * @brief Send disarm command to the flight controller
+   * @brief Send disarm command to the flight controller. Non-blocking, the command is sent with the next RC frame
    *
-   * @return true if disarming was succesfull, false otherwise
+   * @return true if disarming was succesfull, false otherwise (e.g. the link is down, the command being sent once it
+   * is back)
    */
   [[nodiscard]] bool disarm();
 
   /**
-   * @brief Send a command to the flight controller to set the RC channels (TAER mapping)
+   * @brief Send a command to the flight controller to set the RC channels (TAER mapping). Non-blocking, the
+   * channels are sent with the next RC frame, and intermediate updates are merged
    *
    * @param throttle throttle channel value [1000, 2000]
    * @param roll roll channel value [1000, 2000]
    * @param pitch pitch channel value [1000, 2000]
    * @param yaw yaw channel value [1000, 2000]
-   * @return true if the command was sent succesfully, false otherwise
+   * @return true if the command was sent succesfully, false otherwise (e.g. the link is down, the channels being sent
+   * once it is back)
    */
   [[nodiscard]] bool trpy(const uint16_t& throttle, const uint16_t& roll, const uint16_t& pitch, const uint16_t& yaw);
 
+  /**
+   * @brief Get the latency statistics of the RC frames, from their submission by the RC stream to their being
+   * written
+   *
+   * @return latency statistics (LatencyStats)
+   */
+  inline LatencyStats getCommandLatency() { return engine_->getLatency(Priority::CONTROL); }
+
+  /**
+   * @brief Get the acknowledgment statistics of the commands (RC frames) written without waiting for their
+   * acknowledgment
+   *
+   * @return acknowledgment statistics (AckStats)
+   */
+  inline AckStats getAcks() { return engine_->getAcks(); }
+
+  /**
+   * @brief Get the RC output stream, to tune its rate or inspect its counters
+   *
+   * @return RC stream (reference to RCStream)
+   */
+  inline RCStream& getRCStream() { return *rc_stream_; }
+
+  /**
+   * @brief Get the dataflash downloader, to download the blackbox logs from the onboard flash
+   *
+   * @return dataflash downloader (reference to DataflashDownloader)
+   */
+  inline DataflashDownloader& getDataflash() { return *dataflash_; }
+
+  /**
+   * @brief Get the configuration manager, to snapshot and restore the settings
+   *
+   * @return configuration manager (reference to ConfigManager)
+   */
+  inline ConfigManager& getConfig() { return *config_; }
+
   /// Shared pointer to Logger
   std::shared_ptr<Logger> logger_ = nullptr;
 
  private:
   /**
-   * @brief Request the aux map to the flight controller and register it
-   *
-   * @return true if registration of the aux map was succesfull, false otherwise
+   * @brief Initialization state machine. With a handshake cache, the board is identified first and its cached entry
+   * used right away. The RX map, RC channels and API version queries are pipelined, and the failed ones retried with a
+   * backoff from 10 ms to 100 ms, then the cache entry is refreshed. The MSP version is negotiated once, trying the
+   * other version while the API version is not answered
    */
-  [[nodiscard]] bool registerAuxMap();
+  void initialize();
 
   /**
-   * @brief Reset the RC channels to 1500 (centered) with throttle at 1000
-   *
+   * @brief Wait before retrying, with a backoff doubled up to 100 ms
+   * @param backoff (reference to std::chrono::milliseconds)
+   * @return true if the initialization is still active, false if it has been stopped
+   */
+  [[nodiscard]] bool backoff(std::chrono::milliseconds& backoff);
+
+  /**
+   * @brief Complete the initialization: reset the RC channels to 1500 (centered) with throttle at 1000, then set the
+   * ready flag and call the ready callbacks
+   * @param rx_map (const reference to RXMap)
+   * @param rc (const reference to RCRawIn)
+   * @param api_version (const reference to std::optional<ApiVersion>)
+   */
+  void setReady(const RXMap& rx_map, const RCRawIn& rc, const std::optional<ApiVersion>& api_version);
+
+  /**
+   * @brief Apply an RX map, and reset the RC channels to 1500 (centered) with throttle at 1000
+   * @param rx_map (const reference to RXMap)
+   * @param channels number of RC channels (const reference to size_t)
    * @return true if the reset was succesfull, false otherwise
    */
-  [[nodiscard]] bool resetRC();
+  [[nodiscard]] bool resetRC(const RXMap& rx_map, const size_t& channels);
+
+  /**
+   * @brief Add a subscription to the periodic callback of its message, started if there is none yet
+   * @param msg message (std::unique_ptr<Msg>)
+   * @param subscriber (std::unique_ptr<Subscriber>)
+   * @param freq frequency (float)
+   * @return handle of the subscription, invalid_subscription if the frequency is not valid (size_t)
+   */
+  size_t addSubscription(std::unique_ptr<Msg> msg, std::unique_ptr<Subscriber> subscriber, float freq);
 
   /**
-   * @brief Set the RC channels
+   * @brief Get the periodic callback serving a subscription, the subscriptions mutex must be held
+   * @param id handle of the subscription (const reference to size_t)
+   * @return periodic callback, null if there is no such subscription (pointer to PeriodicCallback)
+   */
+  PeriodicCallback* findSubscription(const size_t& id);
+
+  /**
+   * @brief Publish the RC channels to the RC stream, the RC mutex must be held (single writer)
    *
-   * @return true if the set was succesfull, false otherwise
+   * @return true if the set was succesfull, false otherwise (e.g. the link is down)
    */
   [[noidscard]] bool setRC();
 
@@ -119,14 +457,84 @@ class Interface
   /// Shared pointer to MSP
   std::shared_ptr<MSP> msp_ = nullptr;
 
-  /// Vector of Periodic Callbacks
-  std::vector<PeriodicCallback<std::function<void(const Msg&)>>> pcs_;
+  /// Shared pointer to I/O engine
+  std::shared_ptr<Engine> engine_ = nullptr;
 
-  /// RX map
-  RXMap rx_map_;
+  /// Unique pointer to RC output stream
+  std::unique_ptr<RCStream> rc_stream_ = nullptr;
+
+  /// Unique pointer to dataflash downloader
+  std::unique_ptr<DataflashDownloader> dataflash_ = nullptr;
 
-  /// RC Channels output
+  /// Unique pointer to configuration manager
+  std::unique_ptr<ConfigManager> config_ = nullptr;
+
+  /**
+   * @brief Reconnection loop, reopen the port once lost
+   *
+   * @param watcher Pointer to port watcher, possibly null (std::shared_ptr<PortWatcher>)
+   */
+  void reconnect(std::shared_ptr<PortWatcher> watcher);
+
+  /**
+   * @brief Stop the reconnection thread
+   */
+  void stopReconnect();
+
+  /// Shared pointer to port watcher, and id of the callback watching the port
+  std::shared_ptr<PortWatcher> port_watcher_ = nullptr;
+  size_t port_watch_id_ = 0;
+
+  /// Reconnection thread, its port watcher callback and its wake up condition, protected by mutex
+  std::thread reconnect_th_;
+  bool reconnect_active_ = false;
+  bool port_event_ = false;
+  std::shared_ptr<PortWatcher> reconnect_watcher_ = nullptr;
+  size_t reconnect_watch_id_ = 0;
+  std::mutex reconnect_mtx_;
+  std::condition_variable reconnect_cv_;
+
+  /// Time to recover statistics, protected by mutex
+  LatencyStats recovery_;
+  std::mutex recovery_mtx_;
+
+  /// Periodic Callbacks by message type, the periodic callbacks of the subscriptions by handle, and the next handle,
+  /// protected by mutex. The periodic callbacks never move, so that adding or removing one leaves the others running
+  std::map<std::type_index, std::shared_ptr<PeriodicCallback>> pcs_;
+  std::map<size_t, std::shared_ptr<PeriodicCallback>> subscriptions_;
+  size_t next_pc_id_ = 0;
+  std::mutex pcs_mtx_;
+
+  /// Real-time configuration of the threads, applied to the subscriptions added afterwards (protected by the
+  /// subscriptions mutex)
+  std::optional<RealtimeConfig> realtime_;
+
+  /// Initialization thread, and its stop condition, protected by mutex
+  std::thread init_th_;
+  bool init_active_ = true;
+  std::mutex init_mtx_;
+  std::condition_variable init_cv_;
+
+  /// Ready flag, future and callbacks (protected by the initialization mutex)
+  std::atomic_bool ready_ = false;
+  std::promise<void> ready_promise_;
+  std::shared_future<void> ready_future_;
+  std::vector<std::function<void()>> ready_callbacks_;
+
+  /// Construction time, and startup time
+  std::chrono::steady_clock::time_point construction_time_;
+  std::chrono::nanoseconds startup_time_ = std::chrono::nanoseconds::zero();
+
+  /// API version
+  ApiVersion api_version_;
+
+  /// Handshake cache, null if disabled
+  std::unique_ptr<HandshakeCache> cache_;
+
+  /// RX map, and RC Channels output, protected by mutex (the RX map can be refreshed once ready)
+  RXMap rx_map_;
   RCRawOut rc_raw_out_;
+  std::mutex rc_mtx_;
 };
 }  // namespace mspfci
 
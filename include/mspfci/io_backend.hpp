@@ -0,0 +1,108 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <serial/serial.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "mspfci/defs.hpp"
+#include "mspfci/transport.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Event loop backends driving an AsyncSerialTransport
+ */
+enum class IoBackend
+{
+  AUTO,      ///< io_uring if available, epoll otherwise
+  IO_URING,  ///< io_uring, a pre-posted read into a registered buffer and batched writes
+  EPOLL,     ///< epoll, non-blocking reads and writes on readiness
+};
+
+/// Event loop, defined by the backend
+class IoLoop;
+
+/**
+ * @brief Serial transport driven by a single event loop thread (io_uring, or epoll as fallback).
+ *
+ * Received bytes are pushed by the event loop into a lock-free ring, hence available() and read() never issue a
+ * system call. Written frames are queued and handed to the event loop, which writes all the frames queued since its
+ * last write at once. With io_uring, the read is always posted into a registered buffer, and submissions are batched
+ * with the wait for completions in a single io_uring_enter.
+ */
+class AsyncSerialTransport final : public Transport
+{
+ public:
+  /**
+   * @brief Constructor, open and configure the serial port, and start the event loop
+   * @param port (const reference to std::string)
+   * @param baudrate (const reference to uint32_t)
+   * @param backend (const reference to IoBackend)
+   */
+  AsyncSerialTransport(const std::string& port, const uint32_t& baudrate, const IoBackend& backend = IoBackend::AUTO);
+
+  /**
+   * @brief Constructor, drive an already open and configured file descriptor (e.g. a pty), and start the event loop.
+   * The file descriptor is not closed by the transport
+   * @param fd (int)
+   * @param backend (const reference to IoBackend)
+   */
+  AsyncSerialTransport(int fd, const IoBackend& backend = IoBackend::AUTO);
+
+  /**
+   * @brief Destructor, stop the event loop and close the port
+   */
+  ~AsyncSerialTransport();
+
+  bool isOpen() const override;
+  void close() override;
+  size_t available() override;
+  using Transport::read;
+  size_t read(uint8_t* buffer, size_t size) override;
+  using Transport::write;
+  size_t write(const ConstBuffer* buffers, size_t count) override;
+  void flush() override {}
+  const std::string getPort() const override { return port_; }
+  uint32_t getBaudrate() const override { return serial_ ? serial_->getBaudrate() : 0; }
+  uint32_t getEffectiveBaudrate() const override { return serial_ ? serial_->getEffectiveBaudrate() : 0; }
+
+  /**
+   * @brief Getter. Get the backend in use
+   * @return backend, never AUTO (IoBackend)
+   */
+  IoBackend getBackend() const;
+
+  /**
+   * @brief Getter. Get the number of system calls issued for the I/O of the port (event loop and wake ups)
+   * @return number of system calls (uint64_t)
+   */
+  uint64_t getSyscalls() const;
+
+  /**
+   * @brief Getter. Get the number of frames (calls to write) written
+   * @return number of frames (uint64_t)
+   */
+  uint64_t getFrames() const;
+
+  /**
+   * @brief Check if io_uring is available on this system
+   * @return True if an io_uring instance can be created, False otherwise (bool)
+   */
+  static bool uringAvailable();
+
+ private:
+  /// Serial port, when opened by the transport
+  std::unique_ptr<serial::Serial> serial_;
+
+  /// Port name
+  std::string port_;
+
+  /// Event loop
+  std::unique_ptr<IoLoop> loop_;
+};
+}  // namespace mspfci
+
+#endif  // IO_BACKEND_H
\ No newline at end of file
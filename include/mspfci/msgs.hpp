@@ -3,7 +3,11 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <array>
+#include <iomanip>
+#include <sstream>
+#include <string>
 
 #include "utils.hpp"
 
@@ -58,6 +62,10 @@ class Msg
 
 class Imu final : public Msg
 {
+ public:
+  const std::array<float, 3>& getAcc() const { return acc_; }
+  const std::array<float, 3>& getAng() const { return ang_; }
+
  protected:
   /**
    * @brief Converts raw imu readings to standard units and set imu data
@@ -109,6 +117,9 @@ class Imu final : public Msg
 
 class Altitude final : public Msg
 {
+ public:
+  float getAltitude() const { return altitude_; }
+
  protected:
   /**
    * @brief Converts raw altitude readings to standard units and set altitude
@@ -178,6 +189,18 @@ class RXMap final : public Msg
     return !rx_map_.empty() && succeeded;
   }
 
+  /**
+   * @brief Encode the rx map, as received
+   *
+   * @param raw_rx_map raw rx map data (reference to Bytes)
+   * @return True if encoding has succeeded, False otherwise (bool)
+   */
+  [[nodiscard]] bool encodeMsg(Bytes& raw_rx_map)
+  {
+    raw_rx_map.insert(raw_rx_map.end(), rx_map_.begin(), rx_map_.end());
+    return !rx_map_.empty();
+  }
+
   /**
    * @brief Get code associated to message
    *
@@ -221,6 +244,13 @@ class RCRawOut final : public Msg
    */
   void channels(const std::vector<uint16_t>& rc_channels) { rc_channels_ = rc_channels; }
 
+  /**
+   * @brief Get the RC channels
+   *
+   * @return const std::vector<uint16_t>&
+   */
+  const std::vector<uint16_t>& channels() const { return rc_channels_; }
+
   /**
    * @brief Set a specific the RC channel with bounds check
    *
@@ -326,6 +356,22 @@ class RCRawIn final : public Msg
     return !rc_channels_.empty() && succeeded;
   }
 
+  /**
+   * @brief Encode the rc channels, as received
+   *
+   * @param raw_rc Raw rc data (reference to Bytes)
+   * @return True if encoding has succeeded, False otherwise (bool)
+   */
+  [[nodiscard]] bool encodeMsg(Bytes& raw_rc)
+  {
+    bool succeeded = !rc_channels_.empty();
+    for (const uint16_t it : rc_channels_)
+    {
+      succeeded &= encode(it, raw_rc);
+    }
+    return succeeded;
+  }
+
   /**
    * @brief Get code associated to message
    *
@@ -357,6 +403,242 @@ class RCRawIn final : public Msg
   MSPCode code_ = MSPCode::MSP_RC;
 };
 
+class ApiVersion final : public Msg
+{
+ public:
+  uint8_t getProtocol() const { return protocol_; }
+  uint8_t getMajor() const { return major_; }
+  uint8_t getMinor() const { return minor_; }
+
+ protected:
+  /**
+   * @brief Decode the MSP protocol and API versions
+   *
+   * @param raw_api_version raw api version data (const reference to Bytes)
+   * @return True if decoding has succeeded, Flase otherwise (bool)
+   */
+  [[nodiscard]] bool decodeMsg(const Bytes& raw_api_version)
+  {
+    return decode<uint8_t>(raw_api_version, protocol_, 0) & decode<uint8_t>(raw_api_version, major_, 1) &
+           decode<uint8_t>(raw_api_version, minor_, 2);
+  }
+
+  /**
+   * @brief Encode the MSP protocol and API versions, as received
+   *
+   * @param raw_api_version raw api version data (reference to Bytes)
+   * @return True if encoding has succeeded, False otherwise (bool)
+   */
+  [[nodiscard]] bool encodeMsg(Bytes& raw_api_version)
+  {
+    return encode(protocol_, raw_api_version) & encode(major_, raw_api_version) & encode(minor_, raw_api_version);
+  }
+
+  /**
+   * @brief Get code associated to message
+   *
+   * @return MSP code (constant reference to MSPCode)
+   */
+  const MSPCode& code() const { return code_; }
+
+  /**
+   * @brief Function to stream the api version
+   *
+   * @param stream reference to std::ostream
+   * @return reference to std::ostream
+   */
+  std::ostream& streamMsg(std::ostream& stream) const
+  {
+    stream << "API Version: " << static_cast<uint>(major_) << "." << static_cast<uint>(minor_) << " (protocol "
+           << static_cast<uint>(protocol_) << ")";
+    return stream;
+  }
+
+ private:
+  /// MSP protocol version, and API major and minor versions
+  uint8_t protocol_ = 0;
+  uint8_t major_ = 0;
+  uint8_t minor_ = 0;
+
+  /// MSP code associated to message
+  MSPCode code_ = MSPCode::MSP_API_VERSION;
+};
+
+class FcVersion final : public Msg
+{
+ public:
+  uint8_t getMajor() const { return major_; }
+  uint8_t getMinor() const { return minor_; }
+  uint8_t getPatch() const { return patch_; }
+
+  /**
+   * @brief Get the firmware version as a string
+   *
+   * @return version "major.minor.patch" (std::string)
+   */
+  std::string str() const
+  {
+    return std::to_string(major_) + "." + std::to_string(minor_) + "." + std::to_string(patch_);
+  }
+
+ protected:
+  /**
+   * @brief Decode the firmware version
+   *
+   * @param raw_fc_version raw firmware version data (const reference to Bytes)
+   * @return True if decoding has succeeded, Flase otherwise (bool)
+   */
+  [[nodiscard]] bool decodeMsg(const Bytes& raw_fc_version)
+  {
+    return decode<uint8_t>(raw_fc_version, major_, 0) & decode<uint8_t>(raw_fc_version, minor_, 1) &
+           decode<uint8_t>(raw_fc_version, patch_, 2);
+  }
+
+  /**
+   * @brief Get code associated to message
+   *
+   * @return MSP code (constant reference to MSPCode)
+   */
+  const MSPCode& code() const { return code_; }
+
+  /**
+   * @brief Function to stream the firmware version
+   *
+   * @param stream reference to std::ostream
+   * @return reference to std::ostream
+   */
+  std::ostream& streamMsg(std::ostream& stream) const
+  {
+    stream << "FC Version: " << str();
+    return stream;
+  }
+
+ private:
+  /// Firmware major, minor and patch versions
+  uint8_t major_ = 0;
+  uint8_t minor_ = 0;
+  uint8_t patch_ = 0;
+
+  /// MSP code associated to message
+  MSPCode code_ = MSPCode::MSP_FC_VERSION;
+};
+
+class DataflashSummary final : public Msg
+{
+ public:
+  bool isReady() const { return flags_ & 0x01; }
+  bool isSupported() const { return flags_ & 0x02; }
+  uint32_t getSectors() const { return sectors_; }
+  uint32_t getTotalSize() const { return total_size_; }
+  uint32_t getUsedSize() const { return used_size_; }
+
+ protected:
+  /**
+   * @brief Decode the state of the onboard flash
+   *
+   * @param raw_summary raw dataflash summary data (const reference to Bytes)
+   * @return True if decoding has succeeded, Flase otherwise (bool)
+   */
+  [[nodiscard]] bool decodeMsg(const Bytes& raw_summary)
+  {
+    return decode<uint8_t>(raw_summary, flags_, 0) & decode<uint32_t>(raw_summary, sectors_, 1) &
+           decode<uint32_t>(raw_summary, total_size_, 5) & decode<uint32_t>(raw_summary, used_size_, 9);
+  }
+
+  /**
+   * @brief Get code associated to message
+   *
+   * @return MSP code (constant reference to MSPCode)
+   */
+  const MSPCode& code() const { return code_; }
+
+  /**
+   * @brief Function to stream the dataflash summary
+   *
+   * @param stream reference to std::ostream
+   * @return reference to std::ostream
+   */
+  std::ostream& streamMsg(std::ostream& stream) const
+  {
+    stream << "Dataflash: " << (isSupported() ? "" : "not ") << "supported, " << (isReady() ? "" : "not ")
+           << "ready, " << used_size_ << "/" << total_size_ << " bytes used, " << sectors_ << " sectors";
+    return stream;
+  }
+
+ private:
+  /// Flags (bit 0 ready, bit 1 supported)
+  uint8_t flags_ = 0;
+
+  /// Number of sectors, total and used size in bytes
+  uint32_t sectors_ = 0;
+  uint32_t total_size_ = 0;
+  uint32_t used_size_ = 0;
+
+  /// MSP code associated to message
+  MSPCode code_ = MSPCode::MSP_DATAFLASH_SUMMARY;
+};
+
+class BoardUid final : public Msg
+{
+ public:
+  const std::array<uint32_t, 3>& getUid() const { return uid_; }
+
+  /**
+   * @brief Get the unique id as an hexadecimal string
+   *
+   * @return unique id (std::string)
+   */
+  std::string str() const
+  {
+    std::ostringstream stream;
+    stream << std::hex << std::setfill('0');
+    for (const uint32_t it : uid_)
+    {
+      stream << std::setw(8) << it;
+    }
+    return stream.str();
+  }
+
+ protected:
+  /**
+   * @brief Decode the unique id of the MCU
+   *
+   * @param raw_uid raw unique id data (const reference to Bytes)
+   * @return True if decoding has succeeded, Flase otherwise (bool)
+   */
+  [[nodiscard]] bool decodeMsg(const Bytes& raw_uid)
+  {
+    return decode<uint32_t>(raw_uid, uid_.at(0), 0) & decode<uint32_t>(raw_uid, uid_.at(1), 4) &
+           decode<uint32_t>(raw_uid, uid_.at(2), 8);
+  }
+
+  /**
+   * @brief Get code associated to message
+   *
+   * @return MSP code (constant reference to MSPCode)
+   */
+  const MSPCode& code() const { return code_; }
+
+  /**
+   * @brief Function to stream the unique id
+   *
+   * @param stream reference to std::ostream
+   * @return reference to std::ostream
+   */
+  std::ostream& streamMsg(std::ostream& stream) const
+  {
+    stream << "UID: " << str();
+    return stream;
+  }
+
+ private:
+  /// Unique id of the MCU (96 bits)
+  std::array<uint32_t, 3> uid_ = {0, 0, 0};
+
+  /// MSP code associated to message
+  MSPCode code_ = MSPCode::MSP_UID;
+};
+
 }  // namespace mspfci
 
 #endif  // MSGS_H
\ No newline at end of file
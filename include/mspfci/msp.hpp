@@ -1,16 +1,20 @@
 #ifndef MSP_H
 #define MSP_H
 
-#include <serial/serial.h>
-
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #include "logger.hpp"
 #include "mspfci/defs.hpp"
 #include "mspfci/msgs.hpp"
+#include "mspfci/parser.hpp"
+#include "mspfci/transport.hpp"
 #include "utils.hpp"
 
 namespace mspfci
@@ -31,47 +35,164 @@ class MSP
       const MSPVer& ver = MSPVer::MSPv1);
 
   /**
-   * @brief Getter. Get port of the serial connection
+   * @brief Constructor
+   * @param logger (std::shared_ptr<Logger>)
+   * @param transport (std::unique_ptr<Transport>)
+   * @param ver (const reference to MSPVer)
+   */
+  MSP(std::shared_ptr<Logger> logger, std::unique_ptr<Transport> transport, const MSPVer& ver = MSPVer::MSPv1);
+
+  /**
+   * @brief Getter. Get port of the connection
    * @return port (const std::string)
    */
-  inline const std::string getPort() const { return serial_->getPort(); }
+  inline const std::string getPort() const { return transport_->getPort(); }
+
+  /**
+   * @brief Getter. Get baudrate of the connection
+   * @return baudrate (uint32_t)
+   */
+  inline uint32_t getBaudrate() const { return transport_->getBaudrate(); }
 
   /**
-   * @brief Getter. Get baudrate of the serial connection
+   * @brief Getter. Get the baudrate actually in effect on the connection, as set by the driver
    * @return baudrate (uint32_t)
    */
-  inline uint32_t getBaudrate() const { return serial_->getBaudrate(); }
+  inline uint32_t getEffectiveBaudrate() const { return transport_->getEffectiveBaudrate(); }
 
   /**
-   * @brief Getter. Get the MSP version in use
+   * @brief Getter. Get the time needed to transmit one byte (start bit, 8 data bits, stop bit) at the effective
+   * baudrate of the connection, zero if the baudrate is not meaningful
+   * @return byte time (std::chrono::nanoseconds)
+   */
+  inline std::chrono::nanoseconds getByteTime() const
+  {
+    const uint32_t baudrate = transport_->getEffectiveBaudrate();
+    return baudrate == 0 ? std::chrono::nanoseconds::zero() : std::chrono::nanoseconds(10000000000ull / baudrate);
+  }
+
+  /**
+   * @brief Getter. Get the receive timeout
+   * @return timeout (const reference to std::chrono::nanoseconds)
+   */
+  inline const std::chrono::nanoseconds& getTimeout() const { return timeout_; }
+
+  /**
+   * @brief Setter. Set the receive timeout, the maximum time a receive waits for the beginning of a response. The
+   * transmission time of the received bytes is added to it as they arrive
+   * @param timeout (const reference to std::chrono::nanoseconds)
+   */
+  inline void setTimeout(const std::chrono::nanoseconds& timeout) { timeout_ = timeout; }
+
+  /**
+   * @brief Setter. Set the time a wait for data spins, yielding, before sleeping between polls. Spinning only lets
+   * the threads of the same priority run, hence a real-time thread waiting must sleep not to starve the lower
+   * priority threads sharing its core
+   * @param time (const reference to std::chrono::nanoseconds)
+   */
+  inline void setSpinTime(const std::chrono::nanoseconds& time) { spin_time_ = time; }
+
+  /**
+   * @brief Wait before polling the connection again: yield while within the spin time from the beginning of the
+   * wait, sleep afterwards
+   * @param start beginning of the wait (const reference to std::chrono::steady_clock::time_point)
+   */
+  inline void backoff(const std::chrono::steady_clock::time_point& start)
+  {
+    if (std::chrono::steady_clock::now() - start < spin_time_.load())
+    {
+      std::this_thread::yield();
+    }
+    else
+    {
+      std::this_thread::sleep_for(poll_period);
+    }
+  }
+
+  /**
+   * @brief Check if the connection is open
+   * @return True if the connection is open, False otherwise (bool)
+   */
+  inline bool isOpen() const { return transport_->isOpen(); }
+
+  /**
+   * @brief Get the number of received bytes not yet read
+   * @return number of bytes (size_t)
+   */
+  inline size_t available() { return transport_->available() + rx_buffer_.size() - rx_offset_; }
+
+  /**
+   * @brief Getter. Get the MSP version in use for sending
    * @return msp version (const reference to MSPVer)
    */
   inline const MSPVer& getMspVersion() const { return msp_version_; }
 
   /**
-   * @brief Flush the serial
+   * @brief Getter. Get the MSP version of the last received frame
+   * @return msp version (const reference to MSPVer)
    */
-  inline void flush() { serial_->flush(); }
+  inline const MSPVer& getReceivedVersion() const { return received_version_; }
 
   /**
-   * @brief Setter. Set the MSP version
+   * @brief Getter. Get the number of received frames dropped because of a checksum mismatch
+   * @return number of frames (uint64_t)
+   */
+  inline uint64_t getCrcErrors() const { return parser_.getCrcErrors(); }
+
+  /**
+   * @brief Flush the connection, dropping the received data not parsed yet and the partially received frame
+   */
+  inline void flush()
+  {
+    discardReceived();
+    transport_->flush();
+  }
+
+  /**
+   * @brief Close the connection, a pending receive returns as soon as no more data is available
+   */
+  inline void close() { transport_->close(); }
+
+  /**
+   * @brief Reopen the connection once its endpoint is back, the caller must hold the MSP mutex
+   * @return True if the connection is open again, False otherwise (bool)
+   */
+  [[nodiscard]] inline bool reopen()
+  {
+    discardReceived();
+    return transport_->reopen();
+  }
+
+  /**
+   * @brief Setter. Set the MSP version used for sending, frames of both versions are received anyway. The caller
+   * must hold the MSP mutex once the connection is in use
    * @param ver (const reference to MSPVer) msp version
    */
   inline void setMspVersion(const MSPVer& ver)
   {
     logger_->info("MSP::setMspVersion: Setting version to MSPv" + enum_to_string(ver));
     msp_version_ = (ver == MSPVer::MSPv1) ? MSPVer::MSPv1 : MSPVer::MSPv2;
-    max_payload_bytes_ = (ver == MSPVer::MSPv1) ? 255 : 65535;
+    received_version_ = msp_version_;
   }
 
   /**
-   * @brief Send data through serial connection
+   * @brief Send data through serial connection, in the version in use, or in MSPv2 for the codes from 256 on
    * @param code (const reference to MSPCode)
    * @param data (const reference to Bytes)
    * @return True if send has succeeded, False otherwise (bool)
    */
   [[nodiscard]] bool send(const MSPCode& code, const Bytes& data);
 
+  /**
+   * @brief Send a response through serial connection, as the flight controller would, in the version of the last
+   * received frame
+   * @param code (const reference to MSPCode)
+   * @param data (const reference to Bytes)
+   * @param error (const reference to bool) true to flag the response as an error
+   * @return True if send has succeeded, False otherwise (bool)
+   */
+  [[nodiscard]] bool respond(const MSPCode& code, const Bytes& data, const bool& error = false);
+
   /**
    * @brief Receive data through serial connection
    * @param data (reference to Bytes)
@@ -79,49 +200,86 @@ class MSP
    */
   [[nodiscard]] bool receive(Bytes& data);
 
+  /**
+   * @brief Receive data through serial connection
+   * @param code (reference to MSPCode) code of the received message
+   * @param data (reference to Bytes)
+   * @return True if receive has succeeded, False otherwise (bool)
+   */
+  [[nodiscard]] bool receive(MSPCode& code, Bytes& data);
+
+  /**
+   * @brief Receive a frame only if it is complete with the bytes already received, never waiting for more data. A
+   * partially received frame stays in the parser, to be completed by the next receive
+   * @param code (reference to MSPCode) code of the received message
+   * @param data (reference to Bytes)
+   * @return True if a frame has been received, False otherwise (bool)
+   */
+  [[nodiscard]] bool tryReceive(MSPCode& code, Bytes& data);
+
   /// MSP Mutex
   std::mutex msp_mtx_;
 
  private:
+  /// Maximum payload size, of MSPv2 and MSPv1 jumbo frames
+  static constexpr size_t max_payload_bytes = 65535;
+
+  /// Period of the polls of the connection once the spin time has elapsed
+  static constexpr std::chrono::nanoseconds poll_period = std::chrono::microseconds(20);
+
   /**
-   * @brief Pack data to be sent according to the version
+   * @brief Pack data and write it to the connection
    * @param code (const reference to MSPCode)
    * @param data (const reference to Bytes)
-   * @return packed data (const Bytes)
+   * @param direction (const reference to uint8_t)
+   * @param version (const reference to MSPVer)
+   * @return True if write has succeeded, False otherwise (bool)
    */
-  const Bytes pack(const MSPCode& code, const Bytes& data);
+  [[nodiscard]] bool write(const MSPCode& code, const Bytes& data, const uint8_t& direction, const MSPVer& version);
 
   /**
-   * @brief Unpack received bytes, and check crc
-   * @param read_buffer (reference to Bytes) packed data
-   * @param data (reference to Bytes)
-   * @return True if unpack succeeded, Flase otherwise (bool)
+   * @brief Wait until the given number of bytes is available
+   * @param size (size_t)
+   * @return True if the bytes are available, False if the connection was closed or the receive timed out (bool)
    */
-  [[nodiscard]] bool unpack(Bytes& read_buffer, Bytes& data);
+  [[nodiscard]] bool waitAvailable(size_t size);
 
   /**
-   * @brief Compute crc according to the version
-   * @param code (const reference to MSPCode)
-   * @param data (const reference to byte_vector)
-   * @return crc (uint8_t)
+   * @brief Drop the received data not parsed yet and the partially received frame
    */
-  uint8_t crc(const MSPCode& code, const Bytes& data);
+  inline void discardReceived()
+  {
+    rx_buffer_.clear();
+    rx_offset_ = 0;
+    parser_.reset();
+  }
 
   /**
-   * @brief Check crc according to the version
-   * @param code (const reference to MSPCode)
-   * @param data (const reference to byte_vector)
-   * @param version (const reference to int) version of msg received
-   * @return True if check succeeded, false otherwise (bool)
+   * @brief Receive a frame, waiting for data until the deadline of the receive
+   * @param code (reference to MSPCode) code of the received message
+   * @param data (reference to Bytes)
+   * @return True if receive has succeeded, False otherwise (bool)
    */
-  [[nodiscard]] bool checkCrc(const MSPCode& code, const Bytes& data, const MSPVer& version);
+  [[nodiscard]] bool receiveFrame(MSPCode& code, Bytes& data);
+
+  /// Unique pointer to the transport
+  std::unique_ptr<Transport> transport_;
+
+  /// Receive parser, and buffer of the read bytes with the offset of the first one not yet parsed
+  Parser parser_;
+  Bytes rx_buffer_;
+  size_t rx_offset_ = 0;
+
+  /// Time a wait spins before sleeping, spinning only by default
+  std::atomic<std::chrono::nanoseconds> spin_time_ = std::chrono::nanoseconds::max();
 
-  /// Unique pointer to the serial interface
-  std::unique_ptr<serial::Serial> serial_;
+  /// Receive timeout, and deadline of the ongoing receive
+  std::chrono::nanoseconds timeout_ = std::chrono::milliseconds(100);
+  std::chrono::steady_clock::time_point deadline_;
 
-  /// MSP varsion and maximum payload size
+  /// MSP version used for sending, and version of the last received frame
   MSPVer msp_version_;
-  size_t max_payload_bytes_;
+  MSPVer received_version_;
 
   /// Shared pointer to logger
   std::shared_ptr<Logger> logger_;
@@ -0,0 +1,162 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mspfci/defs.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief MSP frame, as received
+ */
+struct Frame
+{
+  /// Version of the frame
+  MSPVer version = MSPVer::MSPv1;
+
+  /// Direction ('<' request, '>' response, '!' error)
+  uint8_t direction = 0;
+
+  /// Code of the message
+  MSPCode code;
+
+  /// Payload
+  Bytes payload;
+};
+
+/**
+ * @brief Incremental MSP parser. Bytes are fed as they arrive, in chunks of any size, without ever waiting for more
+ * data. MSPv1 (including jumbo) and MSPv2 frames are all accepted, each one decoded according to its own header
+ */
+class Parser
+{
+ public:
+  /**
+   * @brief Parse bytes, until a frame is complete or all bytes are consumed
+   * @param data (pointer to const uint8_t)
+   * @param size (size_t)
+   * @return number of bytes consumed (size_t)
+   */
+  size_t parse(const uint8_t* data, size_t size);
+
+  /**
+   * @brief Check if a frame has been completed by the last call to parse. The frame is valid until the next call
+   * @return True if a valid frame is available, False otherwise (bool)
+   */
+  inline bool ready() const { return ready_; }
+
+  /**
+   * @brief Getter. Get the last completed frame
+   * @return frame (const reference to Frame)
+   */
+  inline const Frame& frame() const { return frame_; }
+
+  /**
+   * @brief Getter. Get the number of frames dropped because of a checksum mismatch
+   * @return number of frames (uint64_t)
+   */
+  inline uint64_t getCrcErrors() const { return crc_errors_; }
+
+  /**
+   * @brief Reset the parser, dropping a partially received frame
+   */
+  inline void reset() { state_ = State::IDLE; }
+
+  /// MSPv1 size byte announcing a jumbo frame, whose actual 16-bit size follows the code
+  static constexpr uint8_t jumbo_size = 255;
+
+  /// Maximum size of a frame header ($X<, flag, code, size)
+  static constexpr size_t max_header_size = 8;
+
+  /**
+   * @brief Pack the header of a frame according to the version. MSPv1 payloads from 255 bytes on are announced as
+   * jumbo frames
+   * @param version (const reference to MSPVer)
+   * @param code (const reference to MSPCode)
+   * @param size payload size (size_t)
+   * @param direction (uint8_t) '<' for requests, '>' for responses, '!' for errors
+   * @param header (pointer to uint8_t) at least max_header_size bytes
+   * @return header size (size_t)
+   */
+  static size_t packHeader(const MSPVer& version, const MSPCode& code, size_t size, uint8_t direction, uint8_t* header);
+
+  /**
+   * @brief Pack a frame, appended to the given buffer, see packHeader
+   * @param version (const reference to MSPVer)
+   * @param code (const reference to MSPCode)
+   * @param data payload (pointer to const uint8_t)
+   * @param size payload size (size_t)
+   * @param direction (uint8_t) '<' for requests, '>' for responses, '!' for errors
+   * @param frame (reference to Bytes)
+   */
+  static void pack(const MSPVer& version,
+                   const MSPCode& code,
+                   const uint8_t* data,
+                   size_t size,
+                   uint8_t direction,
+                   Bytes& frame);
+
+  /**
+   * @brief Compute the checksum of a frame according to the version: XOR (MSPv1) or CRC8 DVB-S2 (MSPv2) over the
+   * header from the size (MSPv1) or flag (MSPv2) on, and the payload
+   * @param version (const reference to MSPVer)
+   * @param header (pointer to const uint8_t)
+   * @param header_size (size_t)
+   * @param data payload (pointer to const uint8_t)
+   * @param size payload size (size_t)
+   * @return checksum (uint8_t)
+   */
+  static uint8_t checksum(
+      const MSPVer& version, const uint8_t* header, size_t header_size, const uint8_t* data, size_t size);
+
+  /**
+   * @brief Update a CRC8 DVB-S2 (MSPv2 checksum)
+   * @param crc crc of the previous bytes (uint8_t)
+   * @param data (pointer to const uint8_t)
+   * @param size (size_t)
+   * @return crc (uint8_t)
+   */
+  static uint8_t crc8(uint8_t crc, const uint8_t* data, size_t size);
+
+ private:
+  /**
+   * @brief Parser states, named after the next expected byte
+   */
+  enum class State
+  {
+    IDLE,
+    PROTOCOL,
+    DIRECTION,
+    V1_SIZE,
+    V1_CODE,
+    V1_JUMBO_SIZE_LOW,
+    V1_JUMBO_SIZE_HIGH,
+    V2_FLAG,
+    V2_CODE_LOW,
+    V2_CODE_HIGH,
+    V2_SIZE_LOW,
+    V2_SIZE_HIGH,
+    PAYLOAD,
+    CHECKSUM,
+  };
+
+  /// Current state
+  State state_ = State::IDLE;
+
+  /// Frame being received
+  Frame frame_;
+  size_t size_ = 0;
+  uint16_t code_ = 0;
+  uint8_t crc_ = 0;
+
+  /// Flag to indicate wheater a frame has been completed by the last call to parse
+  bool ready_ = false;
+
+  /// Counters
+  uint64_t crc_errors_ = 0;
+};
+}  // namespace mspfci
+
+#endif  // PARSER_H
\ No newline at end of file
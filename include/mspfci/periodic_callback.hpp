@@ -3,38 +3,96 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include "logger.hpp"
-#include "mspfci/msp.hpp"
+#include "mspfci/engine.hpp"
+#include "mspfci/rate_controller.hpp"
 
 namespace mspfci
 {
-template <typename F>
+/**
+ * @brief Subscriber of a periodic callback, delivered the decoded messages at its own rate. Only the delivery is
+ * type-erased: a message costs one virtual call per subscriber delivered, the price of fanning it out to callables of
+ * different types, negligible next to the round trip of its request. The message is then passed on to the concrete
+ * callback
+ */
+class Subscriber
+{
+ public:
+  /**
+   * @brief Destroy the Subscriber object
+   */
+  virtual ~Subscriber() = default;
+
+  /**
+   * @brief Deliver a decoded message to the callback
+   * @param msg (const reference to Msg)
+   */
+  virtual void deliver(const Msg& msg) = 0;
+
+ private:
+  friend class PeriodicCallback;
+
+  /// Period (the fastest one for the adaptive mode), and time the next delivery is due
+  std::chrono::nanoseconds period_ = std::chrono::nanoseconds::zero();
+  std::chrono::steady_clock::time_point due_ = std::chrono::steady_clock::time_point::min();
+
+  /// Pause flag, and frequency range of the adaptive mode, if enabled
+  bool paused_ = false;
+  std::optional<std::pair<float, float>> adaptive_;
+};
+
+/**
+ * @brief Subscriber keeping the callable with its own type, so that it is called directly (and possibly inlined) by
+ * the delivery, with the message as its concrete type
+ * @tparam F callback type, called with a const reference to T
+ * @tparam T message type, Msg to be called with any message
+ */
+template <typename F, typename T = Msg>
+class TypedSubscriber final : public Subscriber
+{
+ public:
+  /**
+   * @brief Constructor
+   * @param fun Callback function (rvalue reference)
+   */
+  explicit TypedSubscriber(F&& fun) : fun_(std::forward<F>(fun)) {}
+
+  void deliver(const Msg& msg) override { fun_(static_cast<const T&>(msg)); }
+
+ private:
+  /// Callback function
+  F fun_;
+};
+
+/**
+ * @brief Periodic callback, requesting a message at the rate of its fastest subscriber, decoding it once and
+ * delivering it to each subscriber at its own rate. All the subscribers of a message are served by a single periodic
+ * callback, hence the message is requested only once for all of them.
+ *
+ * A subscriber is delivered a message once its period has elapsed since the previous one, give or take half the
+ * request period, and a message is only decoded when a subscriber is due. The thread runs from the construction to
+ * the destruction, adding, pausing and retuning the subscribers only change its schedule.
+ */
 class PeriodicCallback
 {
  public:
   /**
-   * @brief Construct a new Periodic Callback object, activate and start it
+   * @brief Construct a new Periodic Callback object and start it, paused until a subscriber is added
    * @param logger Pointer to logger (std::shared_ptr<Logger>)
-   * @param msp Pointer to msp (std::shared_ptr<MSP>)
-   * @param freq Frequency of the preiodic callback (rvalue reference)
-   * @param fun Callback function (rvalue reference)
-   * @param msg message to be used in callback function (std::unique_ptr<Msg>)
+   * @param engine Pointer to I/O engine (std::shared_ptr<Engine>)
+   * @param msg message to be requested and decoded (std::unique_ptr<Msg>)
    */
-  PeriodicCallback(
-      std::shared_ptr<Logger> logger, std::shared_ptr<MSP> msp, float&& freq, F&& fun, std::unique_ptr<Msg> msg)
-      : logger_(std::move(logger))
-      , msp_(std::move(msp))
-      , period_(std::chrono::nanoseconds(std::chrono::nanoseconds::rep(std::nano::den / freq)))
-      , fun_(std::forward<F>(fun))
-      , msg_(std::move(msg))
-  {
-    start();
-  }
+  PeriodicCallback(std::shared_ptr<Logger> logger, std::shared_ptr<Engine> engine, std::unique_ptr<Msg> msg);
 
   /**
    * @brief Copy constructor
@@ -42,31 +100,9 @@ class PeriodicCallback
   PeriodicCallback(const PeriodicCallback& other) = delete;
 
   /**
-   * @brief Move constructor
+   * @brief Move constructor, not movable since the thread refers to the object
    */
-  PeriodicCallback(PeriodicCallback&& other)
-  {
-    // Stop if active
-    if (other.isActive())
-    {
-      other.stop();
-    }
-
-    // Move
-    logger_ = std::move(other.logger_);
-    msp_ = std::move(other.msp_);
-    period_ = other.period_;
-    fun_ = std::forward<F>(other.fun_);
-    msg_ = std::move(other.msg_);
-
-    // Set ptrs to nullptr
-    other.logger_ = nullptr;
-    other.msp_ = nullptr;
-    other.msg_ = nullptr;
-
-    // start
-    start();
-  }
+  PeriodicCallback(PeriodicCallback&& other) = delete;
 
   /**
    * @brief Assignment operator overloading
@@ -80,171 +116,153 @@ class PeriodicCallback
    * @param other (rvalue reference)
    * @return PeriodicCallback&
    */
-  PeriodicCallback& operator=(PeriodicCallback&& other)
-  {
-    if (this != &other)
-    {
-      // Stop if active
-      if (other.isActive())
-      {
-        other.stop();
-      }
+  PeriodicCallback& operator=(PeriodicCallback&& other) = delete;
+
+  /**
+   * @brief Destroy the Periodic Callback object, stop it
+   */
+  ~PeriodicCallback();
+
+  /**
+   * @brief Check that a frequency can be converted to a period: finite, positive, and with a period that fits in
+   * nanoseconds
+   * @param freq frequency (float)
+   * @return true if the frequency is valid, false otherwise
+   */
+  [[nodiscard]] static bool isValidFrequency(float freq);
 
-      // Move
-      logger_ = std::move(other.logger_);
-      msp_ = std::move(other.msp_);
-      period_ = other.period_;
-      fun_ = std::forward<F>(other.fun_);
-      msg_ = std::move(other.msg_);
+  /**
+   * @brief Add a subscriber, delivered the next message right away
+   * @param id handle of the subscriber (const reference to size_t)
+   * @param subscriber (std::unique_ptr<Subscriber>)
+   * @param freq frequency, must be valid (float)
+   */
+  void add(const size_t& id, std::unique_ptr<Subscriber> subscriber, float freq);
+
+  /**
+   * @brief Remove a subscriber, waiting for the delivery in progress (if any) to complete. Must not be called from
+   * a callback
+   * @param id handle of the subscriber (const reference to size_t)
+   * @return true if no subscriber is left, false otherwise
+   */
+  bool remove(const size_t& id);
+
+  /**
+   * @brief Pause a subscriber, the requests are paused once all the subscribers are
+   * @param id handle of the subscriber (const reference to size_t)
+   */
+  void pause(const size_t& id);
+
+  /**
+   * @brief Resume a subscriber, delivered the next message right away
+   * @param id handle of the subscriber (const reference to size_t)
+   */
+  void resume(const size_t& id);
+
+  /**
+   * @brief Setter. Set a fixed frequency to a subscriber, disabling its adaptive mode. The next request is
+   * rescheduled from the start of the last one
+   * @param id handle of the subscriber (const reference to size_t)
+   * @param freq frequency, must be valid (float)
+   */
+  void setFrequency(const size_t& id, float freq);
 
-      // Set ptrs to nullptr
-      other.logger_ = nullptr;
-      other.msp_ = nullptr;
-      other.msg_ = nullptr;
+  /**
+   * @brief Enable the adaptive mode of a subscriber. While a subscriber is adaptive, the request frequency is adjusted
+   * by an AIMD controller driven by the round trips, failures and CRC errors of the requests, from the highest minimum
+   * (or fixed) frequency to the highest maximum frequency of the subscribers
+   * @param id handle of the subscriber (const reference to size_t)
+   * @param min_freq minimum frequency, must be valid (float)
+   * @param max_freq maximum frequency, must be valid and not below the minimum (float)
+   */
+  void setAdaptive(const size_t& id, float min_freq, float max_freq);
+
+  /**
+   * @brief Getter. Get the frequency a subscriber is delivered at, fixed or adapted
+   * @param id handle of the subscriber (const reference to size_t)
+   * @return frequency, zero if there is no such subscriber (float)
+   */
+  float getFrequency(const size_t& id);
 
-      // start
-      start();
-    }
-    return *this;
-  }
+  /**
+   * @brief Getter. Get the statistics of the adaptive mode, empty if it is disabled
+   * @return statistics (RateStats)
+   */
+  RateStats getRateStats();
 
   /**
-   * @brief Destroy the Periodic Callback object
-   *
+   * @brief Getter. Get the jitter statistics, the lateness of the requests with respect to their schedule
+   * @return jitter statistics (LatencyStats)
    */
-  ~PeriodicCallback() { stop(); }
+  LatencyStats getJitter();
 
   /**
-   * @brief Check if periodic calòback is active
-   * @return true if the periodic callback is active, false otherwise
+   * @brief Getter. Get the number of requests, and of decoded messages
+   * @return number of requests and of decoded messages (std::pair<uint64_t, uint64_t>)
    */
-  [[nodiscard]] inline bool isActive() const { return active_; }
+  std::pair<uint64_t, uint64_t> getCounters() const { return {requests_, decoded_}; }
 
   /**
-   * @brief Set the Callback function, stop if active, assign callback, and restart
-   * @param fun callback function (rvalue reference)
+   * @brief Getter. Get the native handle of the thread
+   * @return native handle (std::thread::native_handle_type)
    */
-  void setCallback(F&& fun)
-  {
-    if (isActive())
-    {
-      stop();
-    }
-    fun_ = std::forward<F>(fun);
-    start();
-  }
+  inline std::thread::native_handle_type getNativeHandle() { return th_.native_handle(); }
 
  private:
   /**
-   * @brief Start the periodic callback
-   */
-  void start()
-  {
-    // Check if already active, if so stop
-    if (active_)
-    {
-      stop();
-    }
-
-    // Activate
-    active_ = true;
-
-    // Execution on a separate thread
-    th_ = std::thread([this]() {
-      // Loop while active
-      while (active_)
-      {
-        // Start time
-        const auto start_time = std::chrono::steady_clock::now();
-
-        // Clear raw data
-        raw_data.clear();
-
-        {
-          // Lock MSP
-          std::scoped_lock lock(msp_->msp_mtx_);
-
-          // Flush serial and send data request
-          if (!msp_->send(msg_->getCode(), mspfci::Bytes()))
-          {
-            logger_->err("Failed to send command");
-            continue;
-          }
-
-          // Receive and read data
-          if (!msp_->receive(raw_data))
-          {
-            logger_->err("Failed to receive data");
-            continue;
-          }
-        }
-
-        // Decode data
-        if (!msg_->decodeMessage(raw_data))
-        {
-          logger_->err("Failed to decode data");
-          continue;
-        }
-
-        // Callback
-        fun_(*msg_);
-
-        // End time
-        const auto end_time = std::chrono::steady_clock::now();
-
-        // Check if expected time was exceeded, if not wait
-        std::chrono::nanoseconds duration = end_time - start_time;
-        if (duration > period_)
-        {
-          logger_->warn("Unable to meet frequency requirements");
-        }
-        else
-        {
-          std::this_thread::sleep_for(period_ - duration);
-        }
-      }
-    });
-  }
-
-  /**
-   * @brief Stop the periodic callback
-   */
-  void stop()
-  {
-    // Deactivate
-    active_ = false;
-
-    // Check if thread joinable, then wait for it to complete its execution (join)
-    if (th_.joinable())
-    {
-      th_.join();
-    }
-  }
+   * @brief Convert a frequency to a period
+   * @param freq frequency, must be valid (float)
+   * @return period (std::chrono::nanoseconds)
+   */
+  static std::chrono::nanoseconds toPeriod(float freq);
+
+  /**
+   * @brief Compute the request period from the subscribers, the mutex must be held
+   */
+  void reschedule();
+
+  /**
+   * @brief Request, decode and deliver the messages until stopped
+   */
+  void run();
 
   /// Thread where the periodic callback is running
   std::thread th_;
 
   /// Flag to indicate wheater the periodic callback is active
-  std::atomic_bool active_ = false;
+  std::atomic_bool active_ = true;
 
   /// Shared pointer to logger
   std::shared_ptr<Logger> logger_ = nullptr;
 
-  /// Shared pointer to MSP
-  std::shared_ptr<MSP> msp_ = nullptr;
-
-  /// Period of the periodic callback
-  /// std::chrono::duration<int64_t, std::nano> period_
-  std::chrono::nanoseconds period_ = std::chrono::nanoseconds::zero();
-
-  /// Callback function
-  F fun_;
+  /// Shared pointer to I/O engine
+  std::shared_ptr<Engine> engine_ = nullptr;
 
   /// Unique pointer to message
   std::unique_ptr<Msg> msg_ = nullptr;
 
   /// raw data
   Bytes raw_data;
+
+  /// Number of requests, and of decoded messages
+  std::atomic<uint64_t> requests_ = 0;
+  std::atomic<uint64_t> decoded_ = 0;
+
+  /// Subscribers by handle, request period, pause flag (no subscriber running), rate controller with its frequency
+  /// range, and jitter statistics, protected by mutex
+  std::map<size_t, std::unique_ptr<Subscriber>> subscribers_;
+  std::chrono::nanoseconds period_ = std::chrono::nanoseconds::zero();
+  bool paused_ = true;
+  std::optional<RateController> rate_;
+  std::pair<float, float> rate_range_ = {0.0f, 0.0f};
+  LatencyStats jitter_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+
+  /// Subscribers due, reused across deliveries, and mutex held while delivering, so that a removed subscriber is
+  /// never delivered again
+  std::vector<Subscriber*> due_;
+  std::mutex delivery_mtx_;
 };
 }  // namespace mspfci
 
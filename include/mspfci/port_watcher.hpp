@@ -0,0 +1,125 @@
+#ifndef PORT_WATCHER_H
+#define PORT_WATCHER_H
+
+#include <serial/serial.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Port events
+ */
+enum class PortEvent
+{
+  ADDED,
+  REMOVED,
+};
+
+/**
+ * @brief Hotplug-aware port watcher. The serial ports are scanned once, then the device table is kept up to date
+ * from the kernel uevents received on a netlink socket (no udev daemon needed), and the registered callbacks are
+ * called as soon as a port is added or removed. The ports are scanned again if uevents are lost
+ */
+class PortWatcher
+{
+ public:
+  /// Event callback, called on the watcher thread with the event and the port
+  using Callback = std::function<void(const PortEvent&, const serial::PortInfo&)>;
+
+  /**
+   * @brief Constructor, scan the serial ports and start watching the uevents
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   */
+  PortWatcher(std::shared_ptr<Logger> logger);
+
+  /**
+   * @brief Destructor, stop watching
+   */
+  ~PortWatcher();
+
+  /**
+   * @brief Getter. Get the cached device table
+   * @return ports (std::vector<serial::PortInfo>)
+   */
+  std::vector<serial::PortInfo> getPorts();
+
+  /**
+   * @brief Check if a port is present
+   * @param port (const reference to std::string)
+   * @return True if the port is present, False otherwise (bool)
+   */
+  bool isPresent(const std::string& port);
+
+  /**
+   * @brief Register a callback
+   * @param callback (Callback)
+   * @return id of the callback (size_t)
+   */
+  size_t addCallback(Callback callback);
+
+  /**
+   * @brief Remove a callback, which is not called anymore once removed: waits for the notification in progress (if
+   * any), unless called from a callback
+   * @param id id of the callback (const reference to size_t)
+   */
+  void removeCallback(const size_t& id);
+
+ private:
+  /**
+   * @brief Watch the uevents, until stopped
+   */
+  void run();
+
+  /**
+   * @brief Handle a uevent
+   * @param data (pointer to const char)
+   * @param size (size_t)
+   */
+  void handle(const char* data, size_t size);
+
+  /**
+   * @brief Scan the ports again, after uevents have been lost, and notify the differences with the device table
+   */
+  void rescan();
+
+  /**
+   * @brief Log an event and call the callbacks, out of the callbacks lock so that they can add or remove callbacks
+   * @param event (const reference to PortEvent)
+   * @param info (const reference to serial::PortInfo)
+   */
+  void notify(const PortEvent& event, const serial::PortInfo& info);
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_;
+
+  /// Netlink socket, and stop event
+  int sock_ = -1;
+  int efd_ = -1;
+
+  /// Watcher thread, and flag to indicate wheater it is active
+  std::thread th_;
+  std::atomic_bool active_ = false;
+
+  /// Device table by port, protected by mutex
+  std::map<std::string, serial::PortInfo> ports_;
+  std::mutex ports_mtx_;
+
+  /// Callbacks by id, protected by mutex, and mutex held while notifying
+  std::map<size_t, Callback> callbacks_;
+  size_t next_id_ = 0;
+  std::mutex callbacks_mtx_;
+  std::mutex notify_mtx_;
+};
+}  // namespace mspfci
+
+#endif  // PORT_WATCHER_H
\ No newline at end of file
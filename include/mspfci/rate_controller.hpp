@@ -0,0 +1,100 @@
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace mspfci
+{
+/**
+ * @brief Statistics of an adaptive rate controller
+ */
+struct RateStats
+{
+  /// Number of samples, healthy or congested
+  uint64_t samples = 0;
+
+  /// Number of congestion signals: failed requests (e.g. timeouts), CRC errors, round trips above the latency
+  /// target, and overruns (round trips longer than the period)
+  uint64_t failures = 0;
+  uint64_t crc_errors = 0;
+  uint64_t slow = 0;
+  uint64_t overruns = 0;
+
+  /// Number of rate decreases
+  uint64_t decreases = 0;
+};
+
+/**
+ * @brief Adaptive rate controller, AIMD (additive increase, multiplicative decrease) within a frequency range.
+ *
+ * Each request outcome is a sample of the link health. A congested sample (failed request, new CRC errors, or round
+ * trip above twice the baseline round trip) halves the frequency, an overrun (round trip longer than the period)
+ * brings it just below the rate the round trip sustains, otherwise the frequency is increased by a hundredth of the
+ * range. The baseline is the lowest round trip over the last one to two windows. A
+ * round trip above the latency target, e.g. the flight controller slowing down, backs off once and becomes the new
+ * baseline, while the overruns keep the frequency within what the slower round trip sustains.
+ */
+class RateController
+{
+ public:
+  /**
+   * @brief Constructor
+   * @param min_freq minimum frequency, the controller starts from, must be positive (float)
+   * @param max_freq maximum frequency, must not be below the minimum (float)
+   */
+  RateController(float min_freq, float max_freq);
+
+  /**
+   * @brief Account the outcome of a request and update the frequency
+   * @param succeeded (const reference to bool)
+   * @param rtt round trip time, from the submission to the completion (const reference to std::chrono::nanoseconds)
+   * @param crc_errors number of CRC errors of the link so far (const reference to uint64_t)
+   * @return frequency (float)
+   */
+  float update(const bool& succeeded, const std::chrono::nanoseconds& rtt, const uint64_t& crc_errors);
+
+  /**
+   * @brief Getter. Get the frequency
+   * @return frequency (float)
+   */
+  inline float getFrequency() const { return freq_; }
+
+  /**
+   * @brief Getter. Get the statistics
+   * @return statistics (const reference to RateStats)
+   */
+  inline const RateStats& getStats() const { return stats_; }
+
+ private:
+  /// Round trips above latency_factor times the baseline, and above it by at least latency_tolerance, are congested
+  static constexpr int64_t latency_factor = 2;
+  static constexpr std::chrono::nanoseconds latency_tolerance = std::chrono::milliseconds(1);
+
+  /// Fraction of the rate sustained by the round trip, the frequency backs off to on an overrun
+  static constexpr double overrun_backoff = 0.9;
+
+  /// Frequency range, step of the additive increase, and frequency
+  float min_freq_;
+  float max_freq_;
+  float step_;
+  float freq_;
+
+  /// Duration of a window of the baseline round trip
+  static constexpr std::chrono::nanoseconds window = std::chrono::seconds(1);
+
+  /// Lowest round trips of the previous and current windows, and start of the current window
+  std::chrono::nanoseconds previous_min_ = std::chrono::nanoseconds::max();
+  std::chrono::nanoseconds current_min_ = std::chrono::nanoseconds::max();
+  std::chrono::steady_clock::time_point window_start_ = std::chrono::steady_clock::now();
+
+  /// Number of CRC errors at the previous sample, none until the first one
+  uint64_t crc_errors_ = 0;
+  bool first_ = true;
+
+  /// Statistics
+  RateStats stats_;
+};
+}  // namespace mspfci
+
+#endif  // RATE_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef RC_STREAM_H
+#define RC_STREAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "logger.hpp"
+#include "mspfci/engine.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief RC output stream. Send the most recent RC channels as MSP_SET_RAW_RC CONTROL frames at a fixed rate, which
+ * also keeps the MSP RX link of the flight controller alive between setpoint updates.
+ *
+ * The channels are published through a sequence lock: setting them never blocks nor allocates, and the updates
+ * published between two frames are merged, only the latest one being sent. There must be a single writer at a
+ * time, the Interface serializes its callers with a mutex.
+ */
+class RCStream
+{
+ public:
+  /// Maximum number of RC channels (MAX_SUPPORTED_RC_CHANNEL_COUNT in Betaflight/INAV)
+  static constexpr size_t max_channels = 18;
+
+  /**
+   * @brief Construct a new RC Stream object and start it. Nothing is sent until channels are set
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   * @param engine Pointer to I/O engine (std::shared_ptr<Engine>)
+   * @param rate Rate of the stream in Hz, throw if it is not positive (const reference to float)
+   */
+  RCStream(std::shared_ptr<Logger> logger, std::shared_ptr<Engine> engine, const float& rate = 50.0);
+
+  /**
+   * @brief Copy constructor
+   */
+  RCStream(const RCStream& other) = delete;
+
+  /**
+   * @brief Assignment operator overloading
+   * @param other (const reference to RCStream)
+   * @return RCStream&
+   */
+  RCStream& operator=(const RCStream& other) = delete;
+
+  /**
+   * @brief Destroy the RC Stream object, stop streaming
+   */
+  ~RCStream();
+
+  /**
+   * @brief Publish the RC channels, sent with the next frame. Lock-free and wait-free
+   * @param channels (const reference to std::vector<uint16_t>)
+   * @return True if the channels were published, False if there are too many channels (bool)
+   */
+  [[nodiscard]] bool set(const std::vector<uint16_t>& channels);
+
+  /**
+   * @brief Getter. Get the latest published RC channels
+   * @return RC channels (std::vector<uint16_t>)
+   */
+  std::vector<uint16_t> get() const;
+
+  /**
+   * @brief Setter. Set the rate of the stream, the previous rate is kept if the rate is not valid
+   * @param rate Rate in Hz (const reference to float)
+   * @return True if the rate was set, False if it is not positive (bool)
+   */
+  [[nodiscard]] bool setRate(const float& rate);
+
+  /**
+   * @brief Getter. Get the number of updates published
+   * @return number of updates (uint64_t)
+   */
+  inline uint64_t getUpdates() const { return seq_.load(std::memory_order_relaxed) / 2; }
+
+  /**
+   * @brief Getter. Get the number of frames sent
+   * @return number of frames (uint64_t)
+   */
+  inline uint64_t getFrames() const { return frames_; }
+
+  /**
+   * @brief Check whether the link is up, i.e. the last frame was sent (true until the first frame)
+   * @return True if the link is up, False otherwise (bool)
+   */
+  inline bool isLinkUp() const { return link_up_; }
+
+  /**
+   * @brief Getter. Get the native handle of the stream thread
+   * @return native handle (std::thread::native_handle_type)
+   */
+  inline std::thread::native_handle_type getNativeHandle() { return th_.native_handle(); }
+
+ private:
+  /**
+   * @brief Read a consistent snapshot of the latest published channels
+   * @param channels (reference to std::vector<uint16_t>)
+   * @return sequence number of the snapshot, 0 if nothing has been published yet (uint64_t)
+   */
+  uint64_t snapshot(std::vector<uint16_t>& channels) const;
+
+  /// Thread where the stream is running
+  std::thread th_;
+
+  /// Flag to indicate wheater the stream is active
+  std::atomic_bool active_ = true;
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_ = nullptr;
+
+  /// Shared pointer to I/O engine
+  std::shared_ptr<Engine> engine_ = nullptr;
+
+  /// Period of the stream
+  std::atomic<std::chrono::nanoseconds> period_;
+
+  /// Sequence lock, odd while the channels are being written, and published channels
+  alignas(64) std::atomic<uint64_t> seq_ = 0;
+  std::atomic<size_t> size_ = 0;
+  std::array<std::atomic<uint16_t>, max_channels> channels_;
+
+  /// Number of frames sent, and whether the last frame was sent
+  std::atomic<uint64_t> frames_ = 0;
+  std::atomic_bool link_up_ = true;
+};
+}  // namespace mspfci
+
+#endif  // RC_STREAM_H
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef READ_AWAITABLE_HPP
+#define READ_AWAITABLE_HPP
+
+#include <memory>
+#include <optional>
+
+#include "mspfci/engine.hpp"
+#include "mspfci/msgs.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Awaitable read of a message. The request is queued to the engine when awaited, and the awaiting coroutine
+ * is resumed on the engine thread once the response is received and decoded.
+ *
+ * @tparam T Message type
+ */
+template <typename T>
+class ReadAwaitable
+{
+ public:
+  /**
+   * @brief Construct a new Read Awaitable object
+   * @param engine Pointer to engine (std::shared_ptr<Engine>)
+   */
+  explicit ReadAwaitable(std::shared_ptr<Engine> engine) : engine_(std::move(engine)) {}
+
+  /**
+   * @brief The request always goes through the engine, never complete synchronously
+   * @return false
+   */
+  bool await_ready() const noexcept { return false; }
+
+  /**
+   * @brief Queue the request, the coroutine is resumed on completion
+   * @tparam H coroutine handle type
+   * @param handle coroutine handle
+   */
+  template <typename H>
+  void await_suspend(H handle)
+  {
+    engine_->submit(msg_.getCode(), Bytes(), [this, handle](const bool& succeeded, const Bytes& data) mutable {
+      succeeded_ = succeeded && msg_.decodeMessage(data);
+      handle.resume();
+    });
+  }
+
+  /**
+   * @brief Get the outcome of the read
+   * @return decoded message, empty if the read failed (std::optional<T>)
+   */
+  std::optional<T> await_resume() { return succeeded_ ? std::optional<T>(std::move(msg_)) : std::nullopt; }
+
+ private:
+  /// Shared pointer to engine
+  std::shared_ptr<Engine> engine_ = nullptr;
+
+  /// Message
+  T msg_;
+
+  /// Outcome of the read
+  bool succeeded_ = false;
+};
+}  // namespace mspfci
+
+#endif  // READ_AWAITABLE_HPP
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Real-time configuration of the threads of an interface, so that they are not delayed by other loads (e.g. a
+ * vision pipeline) sharing the cores.
+ *
+ * SCHED_FIFO and SCHED_RR need CAP_SYS_NICE or a RLIMIT_RTPRIO limit (ulimit -r) at least as high as the priority,
+ * and locking the memory needs CAP_IPC_LOCK or a large enough RLIMIT_MEMLOCK (ulimit -l). Locking the future memory
+ * also locks the whole stack of each thread started afterwards.
+ */
+struct RealtimeConfig
+{
+  /// Scheduling policy of the threads (SCHED_OTHER, SCHED_FIFO or SCHED_RR)
+  int policy = SCHED_OTHER;
+
+  /// Priorities of the I/O threads (engine and RC stream), and of the subscription threads, for SCHED_FIFO and
+  /// SCHED_RR [1, 99]. The I/O threads should not have a lower priority than the subscription threads waiting on them
+  int io_priority = 0;
+  int callback_priority = 0;
+
+  /// Cores the I/O threads, and the subscription threads, are pinned to, empty not to pin them
+  std::vector<int> io_cores;
+  std::vector<int> callback_cores;
+
+  /// Time a wait for data spins before sleeping between polls, with SCHED_FIFO and SCHED_RR, so that the I/O threads
+  /// waiting for a response do not starve the lower priority threads sharing their cores
+  std::chrono::nanoseconds spin_time = std::chrono::microseconds(50);
+
+  /// Lock the current and future memory (mlockall), faulting in the stacks and buffers already mapped
+  bool lock_memory = false;
+
+  /// Size of the heap faulted in and kept (never trimmed) for the allocations to come, when locking the memory
+  size_t prefault_heap = 0;
+};
+
+/**
+ * @brief Set the scheduling policy, priority and affinity of a thread
+ * @param logger Pointer to logger (const reference to std::shared_ptr<Logger>)
+ * @param thread (pthread_t)
+ * @param name name of the thread, for the error messages (const reference to std::string)
+ * @param policy (const reference to int)
+ * @param priority (const reference to int)
+ * @param cores cores to pin the thread to, empty not to pin it (const reference to std::vector<int>)
+ * @return True if the thread has been configured, False otherwise (bool)
+ */
+[[nodiscard]] bool configureThread(const std::shared_ptr<Logger>& logger,
+                                   pthread_t thread,
+                                   const std::string& name,
+                                   const int& policy,
+                                   const int& priority,
+                                   const std::vector<int>& cores);
+
+/**
+ * @brief Lock the current and future memory of the process, and prefault a heap kept for the allocations to come
+ * @param logger Pointer to logger (const reference to std::shared_ptr<Logger>)
+ * @param prefault_heap size of the heap (const reference to size_t)
+ * @return True if the memory has been locked, False otherwise (bool)
+ */
+[[nodiscard]] bool lockMemory(const std::shared_ptr<Logger>& logger, const size_t& prefault_heap);
+}  // namespace mspfci
+
+#endif  // REALTIME_H
\ No newline at end of file
@@ -0,0 +1,157 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mspfci/defs.hpp"
+#include "mspfci/transport.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Chunk of a recorded byte stream, with the time it was received at relative to the start of the recording
+ */
+struct ReplayChunk
+{
+  /// Time of arrival since the beginning of the recording
+  std::chrono::nanoseconds time = std::chrono::nanoseconds::zero();
+
+  /// Received bytes
+  Bytes bytes;
+};
+
+/**
+ * @brief Transport decorator recording every received byte, with its time of arrival, to a file that can be
+ * later replayed by ReplayTransport.
+ *
+ * File format (little endian): "MSPR" magic, followed by records made of the time of arrival in nanoseconds
+ * (uint64_t), the number of bytes (uint32_t) and the bytes themselves.
+ */
+class RecordingTransport final : public Transport
+{
+ public:
+  /**
+   * @brief Constructor
+   * @param transport transport to be recorded (std::unique_ptr<Transport>)
+   * @param path path of the recording file (const reference to std::string)
+   */
+  RecordingTransport(std::unique_ptr<Transport> transport, const std::string& path);
+
+  bool isOpen() const override { return transport_->isOpen(); }
+  void close() override { transport_->close(); }
+  size_t available() override { return transport_->available(); }
+  using Transport::read;
+  size_t read(uint8_t* buffer, size_t size) override;
+  using Transport::write;
+  size_t write(const ConstBuffer* buffers, size_t count) override { return transport_->write(buffers, count); }
+  void flush() override { transport_->flush(); }
+  const std::string getPort() const override { return transport_->getPort(); }
+  uint32_t getBaudrate() const override { return transport_->getBaudrate(); }
+
+ private:
+  /// Recorded transport
+  std::unique_ptr<Transport> transport_;
+
+  /// Recording file
+  std::ofstream file_;
+
+  /// Record being written, reused across reads
+  Bytes record_;
+
+  /// Start time of the recording
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+/**
+ * @brief Transport replaying a recorded byte stream. Written bytes are discarded.
+ *
+ * The stream is replayed either respecting the original time of arrival scaled by a speed factor (speed > 0), or
+ * as fast as possible (speed <= 0). Once the stream is exhausted the transport reports itself as closed, unless it
+ * has been asked to loop.
+ */
+class ReplayTransport final : public Transport
+{
+ public:
+  /**
+   * @brief Constructor. Load a recording produced by RecordingTransport, or a raw byte dump
+   * @param path path of the recording file (const reference to std::string)
+   * @param speed replay speed factor, 1 is the original timing, <= 0 is as fast as possible (const reference to
+   * double)
+   * @param loop restart from the beginning once the stream is exhausted (const reference to bool)
+   */
+  ReplayTransport(const std::string& path, const double& speed = 0.0, const bool& loop = false);
+
+  /**
+   * @brief Constructor. Replay the given chunks
+   * @param chunks recorded stream (std::vector<ReplayChunk>)
+   * @param speed replay speed factor, 1 is the original timing, <= 0 is as fast as possible (const reference to
+   * double)
+   * @param loop restart from the beginning once the stream is exhausted (const reference to bool)
+   */
+  ReplayTransport(std::vector<ReplayChunk> chunks, const double& speed = 0.0, const bool& loop = false);
+
+  bool isOpen() const override { return loop_ || pos_ < stream_.size(); }
+  void close() override;
+  size_t available() override;
+  using Transport::read;
+  size_t read(uint8_t* buffer, size_t size) override;
+  using Transport::write;
+  size_t write(const ConstBuffer* buffers, size_t count) override;
+  void flush() override {}
+  const std::string getPort() const override { return name_; }
+  uint32_t getBaudrate() const override { return 0; }
+
+  /**
+   * @brief Getter. Get the total number of bytes replayed so far
+   * @return number of bytes (uint64_t)
+   */
+  inline uint64_t getBytesReplayed() const { return bytes_replayed_; }
+
+  /**
+   * @brief Getter. Get the size of the recorded stream
+   * @return number of bytes (size_t)
+   */
+  inline size_t size() const { return stream_.size(); }
+
+ private:
+  /**
+   * @brief Append a chunk to the stream
+   * @param chunk (const reference to ReplayChunk)
+   */
+  void append(const ReplayChunk& chunk);
+
+  /**
+   * @brief Release the chunks whose (scaled) time of arrival has elapsed, and restart if looping
+   */
+  void update();
+
+  /// Name of the replayed recording
+  std::string name_ = "replay";
+
+  /// Recorded stream, and end offset and time of arrival of each chunk
+  Bytes stream_;
+  std::vector<std::pair<size_t, std::chrono::nanoseconds>> chunks_;
+
+  /// Speed factor and looping flag
+  double speed_;
+  bool loop_;
+
+  /// Read position, index of the next chunk to be released, and end of the released bytes
+  size_t pos_ = 0;
+  size_t next_chunk_ = 0;
+  size_t released_ = 0;
+
+  /// Start time of the replay, set at first access
+  std::chrono::steady_clock::time_point start_time_;
+  bool started_ = false;
+
+  /// Total number of bytes replayed
+  uint64_t bytes_replayed_ = 0;
+};
+}  // namespace mspfci
+
+#endif  // REPLAY_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.hpp"
+#include "mspfci/msp.hpp"
+#include "mspfci/transport.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Minimal flight controller answering MSP requests on a transport (typically one end of a
+ * LoopbackTransport pair), with synthetic sensor data. Meant for benchmarks and offline testing.
+ */
+class Simulator
+{
+ public:
+  /**
+   * @brief Construct a new Simulator, and start serving requests
+   * @param logger (std::shared_ptr<Logger>)
+   * @param transport (std::unique_ptr<Transport>)
+   * @param ver (const reference to MSPVer)
+   */
+  Simulator(std::shared_ptr<Logger> logger, std::unique_ptr<Transport> transport, const MSPVer& ver = MSPVer::MSPv1);
+
+  /**
+   * @brief Destroy the Simulator, stop serving requests and close the transport
+   */
+  ~Simulator();
+
+  /**
+   * @brief Getter. Get the RC channels last set through MSP_SET_RAW_RC
+   * @return RC channels (std::vector<uint16_t>)
+   */
+  std::vector<uint16_t> getRC();
+
+  /**
+   * @brief Getter. Get the number of requests served
+   * @return number of requests (uint64_t)
+   */
+  inline uint64_t getRequests() const { return requests_; }
+
+  /**
+   * @brief Getter. Get a setting, as stored by the firmware
+   * @param name (const reference to std::string)
+   * @return value, empty if the setting does not exist (Bytes)
+   */
+  Bytes getSetting(const std::string& name);
+
+  /**
+   * @brief Getter. Get the number of EEPROM writes
+   * @return number of writes (uint64_t)
+   */
+  inline uint64_t getEepromWrites() const { return eeprom_writes_; }
+
+  /**
+   * @brief Setter. Set the time taken to serve each request, emulating a loaded MSP task (e.g. heavy OSD or blackbox)
+   * @param time (const reference to std::chrono::nanoseconds)
+   */
+  inline void setServiceTime(const std::chrono::nanoseconds& time) { service_time_ = time; }
+
+  /**
+   * @brief Getter. Get the native handle of the serving thread
+   * @return native handle (std::thread::native_handle_type)
+   */
+  inline std::thread::native_handle_type getNativeHandle() { return th_.native_handle(); }
+
+  /**
+   * @brief Setter. Set the time a wait for a request spins before sleeping between polls, e.g. once the serving thread
+   * is real-time
+   * @param time (const reference to std::chrono::nanoseconds)
+   */
+  inline void setSpinTime(const std::chrono::nanoseconds& time) { msp_->setSpinTime(time); }
+
+  /// Size of the synthetic log in the onboard flash, and maximum size of a read
+  static constexpr uint32_t flash_size = 1 << 20;
+  static constexpr size_t max_flash_read = 4096;
+
+ private:
+  /**
+   * @brief Build the response to a request
+   * @param code (const reference to MSPCode)
+   * @param request (const reference to Bytes)
+   * @param response (reference to Bytes)
+   * @return True if the request is supported, False otherwise (bool)
+   */
+  [[nodiscard]] bool handle(const MSPCode& code, const Bytes& request, Bytes& response);
+
+  /// Thread serving the requests
+  std::thread th_;
+
+  /// Flag to indicate wheater the simulator is active
+  std::atomic_bool active_ = true;
+
+  /// MSP used to parse requests and send responses
+  std::unique_ptr<MSP> msp_;
+
+  /// RC channels
+  std::vector<uint16_t> rc_;
+  std::mutex rc_mtx_;
+
+  /// Settings by name, protected by mutex
+  std::map<std::string, Bytes> settings_;
+  std::mutex settings_mtx_;
+
+  /// Number of EEPROM writes
+  std::atomic<uint64_t> eeprom_writes_ = 0;
+
+  /// Number of requests served
+  std::atomic<uint64_t> requests_ = 0;
+
+  /// Time taken to serve each request
+  std::atomic<std::chrono::nanoseconds> service_time_ = std::chrono::nanoseconds::zero();
+};
+}  // namespace mspfci
+
+#endif  // SIMULATOR_H
\ No newline at end of file
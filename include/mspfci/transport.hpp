@@ -0,0 +1,323 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <serial/serial.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "mspfci/defs.hpp"
+
+namespace mspfci
+{
+/// Contiguous block of bytes to be written, for scatter-gather writes
+using ConstBuffer = serial::ConstBuffer;
+
+/**
+ * @brief Byte stream the MSP frames are sent and received on
+ */
+class Transport
+{
+ public:
+  /**
+   * @brief Destroy the Transport object
+   */
+  virtual ~Transport(){};
+
+  /**
+   * @brief Check if the transport is open
+   * @return True if the transport is open, false otherwise (bool)
+   */
+  virtual bool isOpen() const = 0;
+
+  /**
+   * @brief Close the transport
+   */
+  virtual void close() = 0;
+
+  /**
+   * @brief Get the number of bytes that can be read without blocking
+   * @return number of bytes available (size_t)
+   */
+  virtual size_t available() = 0;
+
+  /**
+   * @brief Read up to size bytes into a caller provided buffer, without allocating
+   * @param buffer buffer of at least size bytes (pointer to uint8_t)
+   * @param size maximum number of bytes to be read (size_t)
+   * @return number of bytes read (size_t)
+   */
+  virtual size_t read(uint8_t* buffer, size_t size) = 0;
+
+  /**
+   * @brief Read up to size bytes and append them to buffer. No allocation happens once the capacity of buffer is
+   * large enough
+   * @param buffer (reference to Bytes)
+   * @param size maximum number of bytes to be read (size_t)
+   * @return number of bytes read (size_t)
+   */
+  inline size_t read(Bytes& buffer, size_t size)
+  {
+    const size_t offset = buffer.size();
+    buffer.resize(offset + size);
+    const size_t bytes_read = read(buffer.data() + offset, size);
+    buffer.resize(offset + bytes_read);
+    return bytes_read;
+  }
+
+  /**
+   * @brief Write several blocks of bytes, in order, with a single scatter-gather write when supported
+   * @param buffers array of count blocks (pointer to const ConstBuffer)
+   * @param count number of blocks (size_t)
+   * @return number of bytes written (size_t)
+   */
+  virtual size_t write(const ConstBuffer* buffers, size_t count) = 0;
+
+  /**
+   * @brief Write data
+   * @param data (const reference to Bytes)
+   * @return number of bytes written (size_t)
+   */
+  inline size_t write(const Bytes& data)
+  {
+    const ConstBuffer buffer = {data.data(), data.size()};
+    return write(&buffer, 1);
+  }
+
+  /**
+   * @brief Flush the transport
+   */
+  virtual void flush() = 0;
+
+  /**
+   * @brief Reopen the transport once its endpoint is back (e.g. a USB device plugged back in). Not supported by
+   * default
+   * @return True if the transport is open again, False otherwise (bool)
+   */
+  virtual bool reopen() { return false; }
+
+  /**
+   * @brief Getter. Get a human readable name of the transport endpoint
+   * @return port (const std::string)
+   */
+  virtual const std::string getPort() const = 0;
+
+  /**
+   * @brief Getter. Get the baudrate of the transport, 0 if not meaningful
+   * @return baudrate (uint32_t)
+   */
+  virtual uint32_t getBaudrate() const = 0;
+
+  /**
+   * @brief Getter. Get the baudrate actually in effect, which may differ from the requested one when the driver
+   * rounds it, 0 if not meaningful
+   * @return baudrate (uint32_t)
+   */
+  virtual uint32_t getEffectiveBaudrate() const { return getBaudrate(); }
+};
+
+/**
+ * @brief Transport over a serial port. The port is read without taking the read lock of serial::Serial, as it is
+ * owned by a single MSP whose receives are serialized. An I/O error (e.g. the USB device unplugged) closes the port
+ * instead of throwing, until it is reopened
+ */
+class SerialTransport final : public Transport
+{
+ public:
+  /**
+   * @brief Constructor, open the serial port
+   * @param port (const reference to std::string)
+   * @param baudrate (const reference to uint32_t)
+   * @param low_latency (const reference to bool) true to enable the low latency mode of the port (ASYNC_LOW_LATENCY).
+   * The port stays non-blocking, as MSP only reads the bytes already received
+   */
+  SerialTransport(const std::string& port, const uint32_t& baudrate, const bool& low_latency = false);
+
+  bool isOpen() const override { return serial_->isOpen(); }
+  void close() override { serial_->close(); }
+  size_t available() override;
+  using Transport::read;
+  size_t read(uint8_t* buffer, size_t size) override;
+  using Transport::write;
+  size_t write(const ConstBuffer* buffers, size_t count) override;
+  void flush() override { serial_->flush(); }
+  bool reopen() override;
+  const std::string getPort() const override { return serial_->getPort(); }
+  uint32_t getBaudrate() const override { return serial_->getBaudrate(); }
+  uint32_t getEffectiveBaudrate() const override { return serial_->getEffectiveBaudrate(); }
+
+  /**
+   * @brief Getter. Get which settings of the low latency mode took effect
+   * @return low latency status (const reference to serial::LowLatencyStatus)
+   */
+  inline const serial::LowLatencyStatus& getLowLatency() const { return low_latency_; }
+
+ private:
+  /**
+   * @brief Close the port after an I/O error, ignoring a failure to close it
+   */
+  void lose();
+
+  /// Unique pointer to the serial interface
+  std::unique_ptr<serial::Serial> serial_;
+
+  /// Low latency mode requested, and settings in effect
+  bool low_latency_requested_;
+  serial::LowLatencyStatus low_latency_;
+};
+
+/**
+ * @brief Transport over a TCP connection (e.g. MSP exposed by Betaflight/INAV SITL)
+ */
+class TcpTransport final : public Transport
+{
+ public:
+  /**
+   * @brief Constructor, connect to the given endpoint
+   * @param host (const reference to std::string)
+   * @param port (const reference to uint16_t)
+   */
+  TcpTransport(const std::string& host, const uint16_t& port);
+
+  /**
+   * @brief Destructor, close the connection
+   */
+  ~TcpTransport() { close(); }
+
+  bool isOpen() const override { return fd_ != -1; }
+  void close() override;
+  size_t available() override;
+  using Transport::read;
+  size_t read(uint8_t* buffer, size_t size) override;
+  using Transport::write;
+  size_t write(const ConstBuffer* buffers, size_t count) override;
+  void flush() override {}
+  const std::string getPort() const override { return name_; }
+  uint32_t getBaudrate() const override { return 0; }
+
+  /**
+   * @brief Setter. Set the timeout of a write, waiting for the peer to read once the socket buffer is full
+   * @param timeout (const reference to std::chrono::milliseconds)
+   */
+  inline void setWriteTimeout(const std::chrono::milliseconds& timeout) { write_timeout_ = timeout; }
+
+ private:
+  /// Socket file descriptor, atomic since the connection is closed from the reading side once the peer is gone
+  std::atomic<int> fd_ = -1;
+
+  /// Timeout of a write
+  std::atomic<std::chrono::milliseconds> write_timeout_ = std::chrono::milliseconds(100);
+
+  /// Endpoint name (host:port)
+  std::string name_;
+};
+
+/**
+ * @brief Transport over UDP datagrams exchanged with a single remote endpoint
+ */
+class UdpTransport final : public Transport
+{
+ public:
+  /**
+   * @brief Constructor, bind the local port and connect to the remote endpoint
+   * @param host (const reference to std::string)
+   * @param port remote port (const reference to uint16_t)
+   * @param local_port local port, 0 for an ephemeral one (const reference to uint16_t)
+   */
+  UdpTransport(const std::string& host, const uint16_t& port, const uint16_t& local_port = 0);
+
+  /**
+   * @brief Destructor, close the socket
+   */
+  ~UdpTransport() { close(); }
+
+  bool isOpen() const override { return fd_ != -1; }
+  void close() override;
+  size_t available() override;
+  using Transport::read;
+  size_t read(uint8_t* buffer, size_t size) override;
+  using Transport::write;
+  size_t write(const ConstBuffer* buffers, size_t count) override;
+  void flush() override {}
+  const std::string getPort() const override { return name_; }
+  uint32_t getBaudrate() const override { return 0; }
+
+ private:
+  /**
+   * @brief Move all the pending datagrams into the receive buffer
+   */
+  void receive();
+
+  /// Socket file descriptor
+  int fd_ = -1;
+
+  /// Endpoint name (host:port)
+  std::string name_;
+
+  /// Received bytes not yet read, datagrams can not be partially read from the socket
+  Bytes rx_buffer_;
+};
+
+/**
+ * @brief In-memory transport. Endpoints are created in connected pairs, each direction being a lock-free single
+ * producer single consumer ring buffer, hence no system call is involved.
+ */
+class LoopbackTransport final : public Transport
+{
+ public:
+  /**
+   * @brief Create a pair of connected endpoints
+   * @param capacity capacity in bytes of each direction, rounded up to a power of two (size_t)
+   * @return pair of connected endpoints
+   */
+  static std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>> pair(
+      size_t capacity = 65536);
+
+  /**
+   * @brief Destructor, close the endpoint
+   */
+  ~LoopbackTransport() { close(); }
+
+  bool isOpen() const override { return !rx_->closed && !tx_->closed; }
+  void close() override;
+  size_t available() override;
+  using Transport::read;
+  size_t read(uint8_t* buffer, size_t size) override;
+  using Transport::write;
+  size_t write(const ConstBuffer* buffers, size_t count) override;
+  void flush() override {}
+  const std::string getPort() const override { return "loopback"; }
+  uint32_t getBaudrate() const override { return 0; }
+
+ private:
+  /**
+   * @brief Single producer single consumer ring buffer
+   */
+  struct Ring
+  {
+    Ring(size_t capacity) : buffer(capacity), mask(capacity - 1) {}
+
+    Bytes buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head = 0;
+    alignas(64) std::atomic<size_t> tail = 0;
+    std::atomic_bool closed = false;
+  };
+
+  /**
+   * @brief Constructor
+   * @param rx ring this endpoint reads from (std::shared_ptr<Ring>)
+   * @param tx ring this endpoint writes to (std::shared_ptr<Ring>)
+   */
+  LoopbackTransport(std::shared_ptr<Ring> rx, std::shared_ptr<Ring> tx) : rx_(std::move(rx)), tx_(std::move(tx)) {}
+
+  /// Receive and transmit rings
+  std::shared_ptr<Ring> rx_;
+  std::shared_ptr<Ring> tx_;
+};
+}  // namespace mspfci
+
+#endif  // TRANSPORT_H
\ No newline at end of file
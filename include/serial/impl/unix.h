@@ -83,6 +83,9 @@ public:
   bool
   isOpen () const;
 
+  int
+  getFd () const;
+
   size_t
   available ();
 
@@ -98,6 +101,9 @@ public:
   size_t
   write (const uint8_t *data, size_t length);
 
+  size_t
+  write (const ConstBuffer *buffers, size_t count);
+
   void
   flush ();
 
@@ -152,6 +158,9 @@ public:
   unsigned long
   getBaudrate () const;
 
+  unsigned long
+  getEffectiveBaudrate () const;
+
   void
   setBytesize (bytesize_t bytesize);
 
@@ -176,6 +185,12 @@ public:
   flowcontrol_t
   getFlowcontrol () const;
 
+  LowLatencyStatus
+  setLowLatency (uint8_t vmin, uint8_t vtime);
+
+  LowLatencyStatus
+  getLowLatency () const;
+
   void
   readLock ();
 
@@ -201,6 +216,7 @@ private:
 
   Timeout timeout_;           // Timeout for read operations
   unsigned long baudrate_;    // Baudrate
+  unsigned long effective_baudrate_; // Baudrate set by the driver
   uint32_t byte_time_ns_;     // Nanoseconds to transmit/receive a single byte
 
   parity_t parity_;           // Parity
@@ -208,6 +224,10 @@ private:
   stopbits_t stopbits_;       // Stop Bits
   flowcontrol_t flowcontrol_; // Flow Control
 
+  uint8_t vmin_;              // VMIN, 0 for non blocking reads
+  uint8_t vtime_;             // VTIME, in tenths of a second
+  LowLatencyStatus low_latency_; // Low latency settings in effect
+
   // Mutex used to lock the read functions
   pthread_mutex_t read_mutex;
   // Mutex used to lock the write functions
@@ -87,6 +87,9 @@ public:
   size_t
   write (const uint8_t *data, size_t length);
 
+  size_t
+  write (const ConstBuffer *buffers, size_t count);
+
   void
   flush ();
 
@@ -141,6 +144,9 @@ public:
   unsigned long
   getBaudrate () const;
 
+  unsigned long
+  getEffectiveBaudrate () const;
+
   void
   setBytesize (bytesize_t bytesize);
 
@@ -165,6 +171,12 @@ public:
   flowcontrol_t
   getFlowcontrol () const;
 
+  LowLatencyStatus
+  setLowLatency (uint8_t vmin, uint8_t vtime);
+
+  LowLatencyStatus
+  getLowLatency () const;
+
   void
   readLock ();
 
@@ -89,6 +89,32 @@ typedef enum {
   flowcontrol_hardware
 } flowcontrol_t;
 
+/*!
+ * Structure describing a contiguous block of bytes to be written, used to
+ * write several blocks (e.g. header, payload and checksum of a frame) with a
+ * single call, without packing them into a contiguous buffer first.
+ */
+struct ConstBuffer {
+  const uint8_t *data;
+  size_t size;
+};
+
+/*!
+ * Structure reporting which settings of the low latency mode took effect,
+ * as read back from the driver.
+ */
+struct LowLatencyStatus {
+  /*! ASYNC_LOW_LATENCY flag set through TIOCSSERIAL (Linux only), which
+   * disables the latency timer of USB-serial adapters. */
+  bool async_low_latency;
+  /*! Requested VMIN/VTIME applied to the port. */
+  bool vmin_vtime;
+
+  LowLatencyStatus (bool async_low_latency_=false, bool vmin_vtime_=false)
+  : async_low_latency(async_low_latency_), vmin_vtime(vmin_vtime_)
+  {}
+};
+
 /*!
  * Structure for setting the timeout of the serial port, times are
  * in milliseconds.
@@ -211,6 +237,16 @@ public:
   bool
   isOpen () const;
 
+#if !defined(_WIN32)
+  /*! Gets the file descriptor of the serial port, -1 if it is not open.
+   *
+   * Meant for external event loops (epoll, io_uring) driving the port
+   * directly, which then own its I/O.
+   */
+  int
+  getFd () const;
+#endif
+
   /*! Closes the serial port. */
   void
   close ();
@@ -264,7 +300,31 @@ public:
   size_t
   read (uint8_t *buffer, size_t size);
 
+  /*! Read a given amount of bytes from the serial port into a given buffer,
+   * without taking the read lock.
+   *
+   * This is meant for ports owned by a single I/O thread, where the locking
+   * is pure overhead. Concurrent reads from several threads through this
+   * function are not safe.
+   *
+   * \param buffer An uint8_t array of at least the requested size.
+   * \param size A size_t defining how many bytes to be read.
+   *
+   * \return A size_t representing the number of bytes read as a result of the
+   *         call to read.
+   *
+   * \see Serial::read
+   *
+   * \throw serial::PortNotOpenedException
+   * \throw serial::SerialException
+   */
+  size_t
+  readUnlocked (uint8_t *buffer, size_t size);
+
   /*! Read a given amount of bytes from the serial port into a give buffer.
+   *
+   * The bytes are appended to the buffer in place, no temporary buffer is
+   * allocated.
    *
    * \param buffer A reference to a std::vector of uint8_t.
    * \param size A size_t defining how many bytes to be read.
@@ -401,6 +461,23 @@ public:
   size_t
   write (const std::string &data);
 
+  /*! Write several blocks of bytes to the serial port, in order, as a
+   * single scatter-gather write (writev on POSIX).
+   *
+   * \param buffers An array of count serial::ConstBuffer.
+   *
+   * \param count A size_t that indicates how many buffers are given.
+   *
+   * \return A size_t representing the total number of bytes actually
+   * written to the serial port.
+   *
+   * \throw serial::PortNotOpenedException
+   * \throw serial::SerialException
+   * \throw serial::IOException
+   */
+  size_t
+  write (const ConstBuffer *buffers, size_t count);
+
   /*! Sets the serial port identifier.
    *
    * \param port A const std::string reference containing the address of the
@@ -508,6 +585,18 @@ public:
   uint32_t
   getBaudrate () const;
 
+  /*! Gets the baudrate actually set by the driver, which may differ from
+   * the requested one when the driver rounds it to an achievable rate.
+   * Arbitrary rates are set on Linux through termios2 and BOTHER.
+   *
+   * \return The effective baud rate, the requested one if it can not be
+   * read back.
+   *
+   * \see Serial::setBaudrate
+   */
+  uint32_t
+  getEffectiveBaudrate () const;
+
   /*! Sets the bytesize for the serial port.
    *
    * \param bytesize Size of each byte in the serial transmission of data,
@@ -586,6 +675,35 @@ public:
   flowcontrol_t
   getFlowcontrol () const;
 
+  /*! Enables the low latency mode of the serial port.
+   *
+   * On Linux the ASYNC_LOW_LATENCY flag is set through TIOCSSERIAL, which
+   * drops the receive latency timer of USB-serial adapters (16ms by default
+   * on FTDI) and asks UART drivers to push received bytes immediately.
+   *
+   * When vmin is not zero the port is switched to blocking reads, and a
+   * read returns as soon as min(vmin, requested) bytes are received, or
+   * vtime tenths of a second after the last received byte. Setting vmin to
+   * the size of a frame header lets a framed read complete in a single
+   * wake up instead of polling. With vmin zero, reads stay non blocking.
+   *
+   * \param vmin Minimum number of bytes of a read (VMIN).
+   * \param vtime Inter byte timeout in tenths of a second (VTIME).
+   *
+   * \return A LowLatencyStatus reporting which settings took effect.
+   *
+   * \throw serial::PortNotOpenedException
+   */
+  LowLatencyStatus
+  setLowLatency (uint8_t vmin = 0, uint8_t vtime = 0);
+
+  /*! Gets the status of the low latency mode, as last set.
+   *
+   * \see Serial::setLowLatency
+   */
+  LowLatencyStatus
+  getLowLatency () const;
+
   /*! Flush the input and output buffers */
   void
   flush ();
@@ -770,6 +888,17 @@ struct PortInfo {
 std::vector<PortInfo>
 list_ports();
 
+#if defined(__linux__)
+/* Describes a single serial port, without scanning the others
+ *
+ * \param port Address of the serial port, e.g. "/dev/ttyACM0".
+ *
+ * \return serial::PortInfo of the port.
+ */
+PortInfo
+port_info(const std::string &port);
+#endif
+
 } // namespace serial
 
 #endif
@@ -20,7 +20,7 @@ template <typename T, typename = std::enable_if_t<std::is_integral_v<T>, T>>
 [[nodiscard]] bool decode(const Bytes& data, T& x, size_t offset = 0)
 {
   // Check data contains enough bytes
-  if ((data.size() - offset) < sizeof(x))
+  if (offset > data.size() || (data.size() - offset) < sizeof(x))
   {
     return false;
   }
@@ -31,7 +31,7 @@ template <typename T, typename = std::enable_if_t<std::is_integral_v<T>, T>>
   // Little endian decoding
   for (size_t i(0); i < sizeof(x); ++i)
   {
-    x |= data.at(i + offset) << (8 * i);
+    x |= static_cast<T>(data.at(i + offset)) << (8 * i);
   }
 
   return true;
@@ -0,0 +1,212 @@
+#include "mspfci/config_manager.hpp"
+
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace mspfci
+{
+ConfigManager::ConfigManager(std::shared_ptr<Logger> logger, std::shared_ptr<Engine> engine)
+    : logger_(std::move(logger)), engine_(std::move(engine))
+{
+}
+
+bool ConfigManager::snapshot(const std::vector<std::string>& names, Settings& settings)
+{
+  // Null-terminated names
+  std::vector<Bytes> requests;
+  requests.reserve(names.size());
+  for (const auto& name : names)
+  {
+    requests.emplace_back(name.begin(), name.end());
+    requests.back().push_back(0);
+  }
+
+  std::vector<Bytes> responses;
+  const bool succeeded = transact(MSPCode::MSP2_COMMON_SETTING, requests, responses);
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    if (responses[i].empty())
+    {
+      logger_->err("ConfigManager: Failed to read " + names[i]);
+      continue;
+    }
+    settings[names[i]] = std::move(responses[i]);
+  }
+  return succeeded;
+}
+
+bool ConfigManager::apply(const Settings& settings)
+{
+  // Null-terminated names, followed by the values
+  std::vector<Bytes> requests;
+  requests.reserve(settings.size());
+  for (const auto& [name, value] : settings)
+  {
+    requests.emplace_back(name.begin(), name.end());
+    requests.back().push_back(0);
+    requests.back().insert(requests.back().end(), value.begin(), value.end());
+  }
+
+  std::vector<Bytes> responses;
+  if (!transact(MSPCode::MSP2_COMMON_SET_SETTING, requests, responses))
+  {
+    logger_->err("ConfigManager: Failed to write the settings");
+    return false;
+  }
+  return true;
+}
+
+bool ConfigManager::commit()
+{
+  Bytes response;
+  if (!engine_->request(MSPCode::MSP_EEPROM_WRITE, Bytes(), response))
+  {
+    logger_->err("ConfigManager: Failed to write the EEPROM");
+    return false;
+  }
+  return true;
+}
+
+bool ConfigManager::restore(const Settings& desired, Settings* changed)
+{
+  // Current settings
+  std::vector<std::string> names;
+  names.reserve(desired.size());
+  for (const auto& [name, value] : desired)
+  {
+    names.push_back(name);
+  }
+  Settings current;
+  if (!snapshot(names, current))
+  {
+    return false;
+  }
+
+  // Write the differing settings only, and commit them once verified
+  const Settings differing = diff(current, desired);
+  if (changed)
+  {
+    *changed = differing;
+  }
+  if (differing.empty())
+  {
+    logger_->info("ConfigManager: Settings up to date");
+    return true;
+  }
+  if (!apply(differing))
+  {
+    return false;
+  }
+  names.clear();
+  for (const auto& [name, value] : differing)
+  {
+    names.push_back(name);
+  }
+  current.clear();
+  if (!snapshot(names, current) || !diff(current, differing).empty())
+  {
+    logger_->err("ConfigManager: Settings not verified, not committed");
+    return false;
+  }
+  logger_->info("ConfigManager: " + std::to_string(differing.size()) + " settings changed");
+  return commit();
+}
+
+Settings ConfigManager::diff(const Settings& current, const Settings& desired)
+{
+  Settings differing;
+  for (const auto& [name, value] : desired)
+  {
+    auto it = current.find(name);
+    if (it == current.end() || it->second != value)
+    {
+      differing.emplace(name, value);
+    }
+  }
+  return differing;
+}
+
+bool ConfigManager::save(const std::string& path, const Settings& settings)
+{
+  std::ofstream file(path, std::ios::trunc);
+  for (const auto& [name, value] : settings)
+  {
+    file << name << " ";
+    for (const uint8_t byte : value)
+    {
+      file << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint>(byte);
+    }
+    file << "\n";
+  }
+  return file.good();
+}
+
+bool ConfigManager::load(const std::string& path, Settings& settings)
+{
+  std::ifstream file(path);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line.front() == '#')
+    {
+      continue;
+    }
+    std::istringstream stream(line);
+    std::string name, hex;
+    if (!(stream >> name >> hex) || hex.size() % 2 != 0)
+    {
+      return false;
+    }
+    Bytes value;
+    for (size_t i = 0; i < hex.size(); i += 2)
+    {
+      try
+      {
+        value.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+      }
+      catch (const std::exception&)
+      {
+        return false;
+      }
+    }
+    settings[name] = std::move(value);
+  }
+  return true;
+}
+
+bool ConfigManager::transact(const MSPCode& code, const std::vector<Bytes>& requests, std::vector<Bytes>& responses)
+{
+  responses.assign(requests.size(), Bytes());
+
+  // Queue all the requests, the engine pipelines them, then wait for all of them to complete
+  std::mutex mtx;
+  std::condition_variable cv;
+  size_t pending = requests.size();
+  bool succeeded = true;
+  for (size_t i = 0; i < requests.size(); ++i)
+  {
+    engine_->submit(code, requests[i], [&, i](const bool& ok, const Bytes& data) {
+      std::scoped_lock lock(mtx);
+      if (ok)
+      {
+        responses[i] = data;
+      }
+      succeeded &= ok;
+      if (--pending == 0)
+      {
+        cv.notify_one();
+      }
+    });
+  }
+  std::unique_lock lock(mtx);
+  cv.wait(lock, [&pending]() { return pending == 0; });
+  return succeeded;
+}
+}  // namespace mspfci
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "mspfci/dataflash.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+namespace mspfci
+{
+DataflashDownloader::DataflashDownloader(std::shared_ptr<Logger> logger, std::shared_ptr<Engine> engine)
+    : logger_(std::move(logger)), engine_(std::move(engine))
+{
+}
+
+bool DataflashDownloader::download(const std::string& path, ProgressCallback progress, const bool& resume)
+{
+  // Size of the used part of the flash
+  Bytes raw_summary;
+  DataflashSummary summary;
+  if (!engine_->request(summary.getCode(), Bytes(), raw_summary) || !summary.decodeMessage(raw_summary))
+  {
+    logger_->err("Dataflash: Failed to read the summary");
+    return false;
+  }
+  if (!summary.isSupported() || !summary.isReady())
+  {
+    logger_->err(std::string("Dataflash: Flash ") + (summary.isSupported() ? "not ready" : "not supported"));
+    return false;
+  }
+  DownloadProgress state;
+  state.total = summary.getUsedSize();
+
+  // Resume from the size of the file, as long as it does not exceed the used size
+  std::error_code ec;
+  const uintmax_t file_size = resume ? std::filesystem::file_size(path, ec) : 0;
+  uint32_t start = !ec && file_size <= state.total ? static_cast<uint32_t>(file_size) : 0;
+  if (start > 0)
+  {
+    // The last chunk of the file must still be on the flash, which otherwise holds a new log since erased
+    const uint32_t size = std::min<uint32_t>(chunk_size_, start);
+    Bytes stored(size);
+    std::ifstream stored_file(path, std::ios::binary);
+    stored_file.seekg(start - size);
+    stored_file.read(reinterpret_cast<char*>(stored.data()), size);
+    Bytes data;
+    if (!readRange(start - size, size, data))
+    {
+      logger_->err("Dataflash: Failed to read " + std::to_string(size) + " bytes at " + std::to_string(start - size));
+      return false;
+    }
+    if (!stored_file || data != stored)
+    {
+      logger_->warn("Dataflash: " + path + " does not match the flash, starting over");
+      start = 0;
+    }
+  }
+  std::ofstream file(path, std::ios::binary | (start > 0 ? std::ios::app : std::ios::trunc));
+  if (!file.is_open())
+  {
+    logger_->err("Dataflash: Failed to open " + path);
+    return false;
+  }
+  if (start > 0)
+  {
+    logger_->info("Dataflash: Resuming at " + std::to_string(start) + "/" + std::to_string(state.total) + " bytes");
+  }
+  state.stored = start;
+
+  const auto start_time = std::chrono::steady_clock::now();
+  uint32_t next = start;
+  uint16_t chunk_size = chunk_size_;
+  std::deque<Read> retries;
+  std::map<uint32_t, Bytes> pending;
+  size_t in_flight = 0;
+  bool failed = false;
+  while (!failed && state.stored < state.total)
+  {
+    // Keep the window full, the reads to be retried first
+    while (in_flight < window_ && (!retries.empty() || next < state.total))
+    {
+      Read read;
+      if (!retries.empty())
+      {
+        read = retries.front();
+        retries.pop_front();
+      }
+      else
+      {
+        read = {next, static_cast<uint16_t>(std::min<uint64_t>(chunk_size, state.total - next)), 0};
+        next += read.size;
+      }
+      submit(read);
+      ++in_flight;
+    }
+
+    // Wait for a read to complete
+    Completion completion = waitCompletion();
+    --in_flight;
+
+    Read& read = completion.read;
+    Bytes data;
+    size_t received = 0;
+    if (completion.succeeded && decodeRead(read, completion.data, data, received) && !data.empty())
+    {
+      // Short read, the remainder is requested again and the next reads are shortened to what the flight controller
+      // answers
+      state.received += received;
+      if (data.size() < read.size)
+      {
+        retries.push_back({static_cast<uint32_t>(read.address + data.size()),
+                           static_cast<uint16_t>(read.size - data.size()),
+                           0});
+        chunk_size = static_cast<uint16_t>(data.size());
+      }
+      data.resize(std::min<size_t>(data.size(), read.size));
+      pending.emplace(read.address, std::move(data));
+    }
+    else if (++read.attempts <= retries_)
+    {
+      logger_->warn("Dataflash: Failed to read " + std::to_string(read.size) + " bytes at " +
+                    std::to_string(read.address) + ", retrying");
+      retries.push_front(read);
+    }
+    else
+    {
+      logger_->err("Dataflash: Failed to read " + std::to_string(read.size) + " bytes at " +
+                   std::to_string(read.address));
+      failed = true;
+    }
+
+    // Store the contiguous chunks, in order
+    bool stored = false;
+    for (auto it = pending.begin(); it != pending.end() && it->first == state.stored; it = pending.erase(it))
+    {
+      file.write(reinterpret_cast<const char*>(it->second.data()), static_cast<std::streamsize>(it->second.size()));
+      state.stored += it->second.size();
+      state.downloaded += it->second.size();
+      stored = true;
+    }
+    if (!file.good())
+    {
+      logger_->err("Dataflash: Failed to write " + path);
+      failed = true;
+    }
+    if (stored && progress)
+    {
+      state.elapsed = std::chrono::steady_clock::now() - start_time;
+      progress(state);
+    }
+  }
+
+  // Wait for the reads still in flight
+  while (in_flight > 0)
+  {
+    waitCompletion();
+    --in_flight;
+  }
+
+  file.flush();
+  if (!failed)
+  {
+    state.elapsed = std::chrono::steady_clock::now() - start_time;
+    logger_->info("Dataflash: Downloaded " + std::to_string(state.downloaded) + " bytes at " +
+                  std::to_string(static_cast<uint64_t>(state.throughput())) + " B/s");
+  }
+  return !failed && file.good();
+}
+
+void DataflashDownloader::submit(const Read& read)
+{
+  // Address, size, and whether compression is allowed
+  Bytes request;
+  bool succeeded = encode(read.address, request);
+  succeeded &= encode(read.size, request);
+  succeeded &= encode(static_cast<uint8_t>(decompressor_ ? 1 : 0), request);
+  if (!succeeded)
+  {
+    std::scoped_lock lock(completions_mtx_);
+    completions_.push_back({read, false, Bytes()});
+    completions_cv_.notify_one();
+    return;
+  }
+
+  engine_->submit(MSPCode::MSP_DATAFLASH_READ, std::move(request), [this, read](const bool& ok, const Bytes& data) {
+    {
+      std::scoped_lock lock(completions_mtx_);
+      completions_.push_back({read, ok, data});
+    }
+    completions_cv_.notify_one();
+  });
+}
+
+DataflashDownloader::Completion DataflashDownloader::waitCompletion()
+{
+  std::unique_lock lock(completions_mtx_);
+  completions_cv_.wait(lock, [this]() { return !completions_.empty(); });
+  Completion completion = std::move(completions_.front());
+  completions_.pop_front();
+  return completion;
+}
+
+bool DataflashDownloader::readRange(const uint32_t& address, const uint32_t& size, Bytes& data)
+{
+  // One read at a time, short reads completed by requesting the remainder
+  data.clear();
+  size_t attempts = 0;
+  while (data.size() < size)
+  {
+    const Read read = {static_cast<uint32_t>(address + data.size()),
+                       static_cast<uint16_t>(std::min<uint64_t>(chunk_size_, size - data.size())),
+                       0};
+    submit(read);
+    const Completion completion = waitCompletion();
+    Bytes chunk;
+    size_t received = 0;
+    if (completion.succeeded && decodeRead(read, completion.data, chunk, received) && !chunk.empty())
+    {
+      chunk.resize(std::min<size_t>(chunk.size(), read.size));
+      data.insert(data.end(), chunk.begin(), chunk.end());
+    }
+    else if (++attempts > retries_)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DataflashDownloader::decodeRead(const Read& read, const Bytes& response, Bytes& data, size_t& received)
+{
+  // Address, size and compression type, followed by the data
+  uint32_t address = 0;
+  uint16_t size = 0;
+  uint8_t compression = 0;
+  if (!decode(response, address, 0) || !decode(response, size, 4) || !decode(response, compression, 6) ||
+      address != read.address)
+  {
+    return false;
+  }
+  received = response.size();
+  const Bytes payload(response.begin() + 7, response.end());
+  if (compression == 0)
+  {
+    data = payload;
+    return data.size() == size;
+  }
+  if (!decompressor_)
+  {
+    logger_->err("Dataflash: Compressed data received, no decompressor set");
+    return false;
+  }
+  return decompressor_(compression, payload, data);
+}
+}  // namespace mspfci
\ No newline at end of file
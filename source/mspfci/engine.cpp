@@ -0,0 +1,367 @@
+#include "mspfci/engine.hpp"
+
+#include <algorithm>
+#include <future>
+
+namespace mspfci
+{
+Engine::Engine(std::shared_ptr<Logger> logger, std::shared_ptr<MSP> msp)
+    : logger_(std::move(logger)), msp_(std::move(msp))
+{
+  batch_.reserve(max_pipeline);
+  th_ = std::thread([this]() {
+    // Loop while active
+    while (active_)
+    {
+      // Wait for a request, and take the highest priority one. If it expects a response, the requests expecting a
+      // response queued right behind it are taken as well, to be pipelined
+      batch_.clear();
+      {
+        std::unique_lock lock(queue_mtx_);
+        Request request;
+        const auto popped = [this, &request]() { return !active_ || pop(request); };
+
+        // While acknowledgments are awaited, wake up to collect them
+        bool awaiting = false;
+        {
+          std::scoped_lock ack_lock(ack_mtx_);
+          awaiting = !acks_.empty();
+        }
+        if (!awaiting)
+        {
+          queue_cv_.wait(lock, popped);
+        }
+        else if (!queue_cv_.wait_for(lock, msp_->getTimeout(), popped))
+        {
+          lock.unlock();
+          std::scoped_lock msp_lock(msp_->msp_mtx_);
+          collectAcks();
+          continue;
+        }
+        if (!active_)
+        {
+          break;
+        }
+        batch_.push_back(std::move(request));
+        while (batch_.front().response && batch_.size() < max_pipeline && nextExpectsResponse() && pop(request))
+        {
+          batch_.push_back(std::move(request));
+        }
+      }
+
+      // Round trips, or write only, and completions
+      if (batch_.front().response)
+      {
+        transact();
+      }
+      else
+      {
+        std::scoped_lock lock(msp_->msp_mtx_);
+        collectAcks();
+        succeeded_[0] = write(batch_.front());
+        responses_[0].clear();
+      }
+      for (size_t i = 0; i < batch_.size(); ++i)
+      {
+        batch_[i].callback(succeeded_[i], responses_[i]);
+      }
+    }
+  });
+}
+
+Engine::~Engine()
+{
+  // Deactivate and wait for the engine thread to complete its execution
+  {
+    std::scoped_lock lock(queue_mtx_);
+    active_ = false;
+  }
+  queue_cv_.notify_all();
+  if (th_.joinable())
+  {
+    th_.join();
+  }
+
+  // Complete pending requests
+  for (auto& lane : lanes_)
+  {
+    for (auto& request : lane)
+    {
+      request.callback(false, Bytes());
+    }
+  }
+}
+
+void Engine::submit(
+    const MSPCode& code, Bytes data, Callback callback, const Priority& priority, const bool& response)
+{
+  {
+    std::scoped_lock lock(queue_mtx_);
+    lanes_[static_cast<size_t>(priority)].push_back(
+        {code, std::move(data), std::move(callback), priority, response, std::chrono::steady_clock::now()});
+    if (priority == Priority::CONTROL && !response)
+    {
+      ++preemptible_;
+    }
+  }
+  queue_cv_.notify_one();
+}
+
+bool Engine::request(const MSPCode& code, const Bytes& data, Bytes& response, const Priority& priority)
+{
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  submit(
+      code,
+      data,
+      [&promise, &response](const bool& succeeded, const Bytes& raw_data) {
+        response = raw_data;
+        promise.set_value(succeeded);
+      },
+      priority);
+  return future.get();
+}
+
+bool Engine::send(const MSPCode& code, const Bytes& data, const Priority& priority, const bool& ack)
+{
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  submit(
+      code, data, [&promise](const bool& succeeded, const Bytes&) { promise.set_value(succeeded); }, priority, ack);
+  return future.get();
+}
+
+LatencyStats Engine::getLatency(const Priority& priority)
+{
+  std::scoped_lock lock(latency_mtx_);
+  return latency_[static_cast<size_t>(priority)];
+}
+
+AckStats Engine::getAcks()
+{
+  std::scoped_lock lock(ack_mtx_);
+  AckStats stats = ack_stats_;
+  stats.pending = acks_.size();
+  return stats;
+}
+
+bool Engine::pop(Request& request)
+{
+  for (auto& lane : lanes_)
+  {
+    if (!lane.empty())
+    {
+      request = std::move(lane.front());
+      lane.pop_front();
+      if (request.priority == Priority::CONTROL && !request.response)
+      {
+        --preemptible_;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Engine::write(const Request& request)
+{
+  if (!msp_->send(request.code, request.data))
+  {
+    logger_->err("Failed to send command");
+    return false;
+  }
+
+  // Latency from submission to the frame being on the wire
+  const auto now = std::chrono::steady_clock::now();
+  const std::chrono::nanoseconds latency = now - request.submitted;
+  {
+    std::scoped_lock lock(latency_mtx_);
+    latency_[static_cast<size_t>(request.priority)].add(latency);
+  }
+
+  // The flight controller acknowledges the request anyway
+  if (!request.response)
+  {
+    std::scoped_lock lock(ack_mtx_);
+    acks_.emplace_back(request.code, now);
+  }
+
+  return true;
+}
+
+bool Engine::nextExpectsResponse() const
+{
+  for (const auto& lane : lanes_)
+  {
+    if (!lane.empty())
+    {
+      return lane.front().response;
+    }
+  }
+  return false;
+}
+
+void Engine::transact()
+{
+  // Lock MSP, and collect the acknowledgments arrived in the meantime
+  std::scoped_lock lock(msp_->msp_mtx_);
+  collectAcks();
+
+  // Write all the requests back to back, the flight controller answers them in order
+  const auto written_time = std::chrono::steady_clock::now();
+  size_t written = 0;
+  while (written < batch_.size() && write(batch_[written]))
+  {
+    ++written;
+  }
+  std::fill(succeeded_.begin(), succeeded_.end(), false);
+
+  for (size_t i = 0; i < written; ++i)
+  {
+    Bytes& data = responses_[i];
+    data.clear();
+
+    // Wait for the response to start arriving, writing the queued commands in the meantime. Frames are written
+    // whole, hence the commands go on the wire at the first frame boundary after their submission
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + msp_->getTimeout();
+    bool started = true;
+    while (msp_->available() == 0)
+    {
+      if (!msp_->isOpen() || std::chrono::steady_clock::now() > deadline)
+      {
+        started = false;
+        break;
+      }
+      if (preemptible_ > 0)
+      {
+        preempt();
+      }
+      msp_->backoff(start);
+    }
+
+    // No response, the next ones would not arrive either
+    if (!started)
+    {
+      logger_->err("Failed to receive data");
+      crc_errors_ = msp_->getCrcErrors();
+      return;
+    }
+
+    // Receive, accounting the frames answering other requests (the acknowledgments of the commands written before
+    // the batch, then of the ones written while waiting) and discarding them, so that only a frame of its own code
+    // completes a request. A failed response (e.g. an error frame) does not fail the next ones. No frame is received
+    // past the deadline once one has been discarded, so that a steady stream of other frames can not hold the
+    // connection
+    MSPCode code;
+    bool discarded = false;
+    while (true)
+    {
+      data.clear();
+      if ((discarded && std::chrono::steady_clock::now() > deadline) || !msp_->receive(code, data))
+      {
+        logger_->err("Failed to receive data");
+        data.clear();
+        break;
+      }
+      discarded = true;
+      if (acknowledge(code, written_time))
+      {
+        continue;
+      }
+      if (code == batch_[i].code)
+      {
+        succeeded_[i] = true;
+        break;
+      }
+      if (!acknowledge(code))
+      {
+        std::scoped_lock ack_lock(ack_mtx_);
+        ++ack_stats_.unexpected;
+      }
+    }
+  }
+  crc_errors_ = msp_->getCrcErrors();
+}
+
+void Engine::preempt()
+{
+  while (true)
+  {
+    // Take the first CONTROL request, as long as it does not expect a response
+    Request request;
+    {
+      std::scoped_lock lock(queue_mtx_);
+      auto& lane = lanes_[static_cast<size_t>(Priority::CONTROL)];
+      if (lane.empty() || lane.front().response)
+      {
+        return;
+      }
+      request = std::move(lane.front());
+      lane.pop_front();
+      --preemptible_;
+    }
+
+    const bool succeeded = write(request);
+    request.callback(succeeded, Bytes());
+  }
+}
+
+bool Engine::acknowledge(const MSPCode& code, const std::chrono::steady_clock::time_point& before)
+{
+  std::scoped_lock lock(ack_mtx_);
+  auto it = std::find_if(acks_.begin(), acks_.end(), [&code](const auto& ack) { return ack.first == code; });
+  if (it == acks_.end() || it->second >= before)
+  {
+    return false;
+  }
+
+  // Acknowledgments are received in order of writing, the ones awaited before have been lost
+  ack_stats_.lost += static_cast<uint64_t>(it - acks_.begin());
+  ++ack_stats_.received;
+  acks_.erase(acks_.begin(), it + 1);
+  return true;
+}
+
+void Engine::collectAcks()
+{
+  // Receive the complete frames only, never waiting for one to arrive: a partially received frame is left in the
+  // parser, and completed by a later receive
+  Bytes data;
+  MSPCode code;
+  while (true)
+  {
+    {
+      std::scoped_lock lock(ack_mtx_);
+      if (acks_.empty())
+      {
+        return;
+      }
+    }
+    if (msp_->available() == 0)
+    {
+      break;
+    }
+    if (!msp_->tryReceive(code, data))
+    {
+      // No complete frame, or an error frame, the next frames are left for later
+      break;
+    }
+    if (!acknowledge(code))
+    {
+      std::scoped_lock lock(ack_mtx_);
+      ++ack_stats_.unexpected;
+    }
+    data.clear();
+  }
+
+  // Expire the acknowledgments awaited for longer than the timeout
+  const auto expiry = std::chrono::steady_clock::now() - msp_->getTimeout();
+  std::scoped_lock lock(ack_mtx_);
+  while (!acks_.empty() && acks_.front().second < expiry)
+  {
+    acks_.pop_front();
+    ++ack_stats_.lost;
+  }
+}
+}  // namespace mspfci
\ No newline at end of file
@@ -0,0 +1,582 @@
+#include "mspfci/fleet_manager.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <deque>
+#include <stdexcept>
+#include <thread>
+
+#include "mspfci/parser.hpp"
+#include "mspfci/periodic_callback.hpp"
+
+namespace mspfci
+{
+/**
+ * @brief Subscription of a flight controller
+ */
+struct FleetManager::Subscription
+{
+  /// Period, and time the next request is due
+  std::chrono::nanoseconds period;
+  std::chrono::steady_clock::time_point next;
+
+  /// Message to be decoded, and callback
+  std::unique_ptr<Msg> msg;
+  Callback callback;
+
+  /// Flag to indicate wheater a request is queued or in flight
+  bool pending = false;
+};
+
+/**
+ * @brief Flight controller of the fleet, owned and accessed by its loop
+ */
+struct FleetManager::Controller
+{
+  /// Index of the flight controller
+  size_t index;
+
+  /// File descriptor, and serial port owning it if any
+  int fd;
+  std::unique_ptr<serial::Serial> serial;
+
+  /// MSP version of the requests, and incremental parser of the responses
+  MSPVer version;
+  Parser parser;
+
+  /// Bytes to be written
+  Bytes tx;
+  size_t tx_offset = 0;
+  bool watching_writable = false;
+
+  /// Subscriptions (stable addresses), and subscriptions due waiting for the request in flight
+  std::vector<std::unique_ptr<Subscription>> subscriptions;
+  std::deque<Subscription*> queue;
+
+  /// Request in flight, and the time it was written
+  Subscription* in_flight = nullptr;
+  std::chrono::steady_clock::time_point sent;
+
+  /// Response timeout
+  std::chrono::nanoseconds timeout;
+
+  /// Flag to indicate wheater the port is open
+  bool open = true;
+
+  /// Statistics
+  FleetStats stats;
+};
+
+/**
+ * @brief epoll event loop, serving its flight controllers. The timer fires when the next subscription is due or the
+ * next request times out
+ */
+class FleetManager::Loop
+{
+ public:
+  /**
+   * @brief Constructor, start the loop thread
+   * @param logger Pointer to logger (std::shared_ptr<Logger>)
+   * @param core core to pin the thread to, negative not to pin it (int)
+   */
+  Loop(std::shared_ptr<Logger> logger, int core) : logger_(std::move(logger))
+  {
+    epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    tfd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epfd_ == -1 || tfd_ == -1 || ::epoll_ctl(epfd_, EPOLL_CTL_ADD, tfd_, &event) == -1)
+    {
+      // The destructor does not run, the descriptors already open are closed here
+      const std::string error = strerror(errno);
+      if (tfd_ != -1)
+      {
+        ::close(tfd_);
+      }
+      if (epfd_ != -1)
+      {
+        ::close(epfd_);
+      }
+      throw std::runtime_error("Failed to set up the event loop: " + error);
+    }
+
+    th_ = std::thread([this]() { run(); });
+    if (core >= 0)
+    {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(core, &cpus);
+      if (pthread_setaffinity_np(th_.native_handle(), sizeof(cpus), &cpus) != 0)
+      {
+        logger_->warn("FleetManager: Failed to pin the event loop to core " + std::to_string(core));
+      }
+    }
+  }
+
+  /**
+   * @brief Destructor, stop the loop thread and close the ports
+   */
+  ~Loop()
+  {
+    active_ = false;
+    wake();
+    if (th_.joinable())
+    {
+      th_.join();
+    }
+    ::close(tfd_);
+    ::close(epfd_);
+  }
+
+  /**
+   * @brief Add a flight controller
+   * @param index index of the flight controller (size_t)
+   * @param fd (int)
+   * @param serial (std::unique_ptr<serial::Serial>)
+   * @param ver (const reference to MSPVer)
+   * @param timeout (const reference to std::chrono::nanoseconds)
+   * @return flight controller (pointer to Controller)
+   */
+  Controller* add(size_t index,
+                  int fd,
+                  std::unique_ptr<serial::Serial> serial,
+                  const MSPVer& ver,
+                  const std::chrono::nanoseconds& timeout)
+  {
+    auto controller = std::make_unique<Controller>();
+    controller->index = index;
+    controller->fd = fd;
+    controller->serial = std::move(serial);
+    controller->version = ver;
+    controller->timeout = timeout;
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    std::scoped_lock lock(mtx_);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = controller.get();
+    if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &event) == -1)
+    {
+      throw std::runtime_error(std::string("Failed to add the port to the event loop: ") + strerror(errno));
+    }
+    controllers_.push_back(std::move(controller));
+    return controllers_.back().get();
+  }
+
+  /**
+   * @brief Subscribe to a message of a flight controller
+   * @param controller (pointer to Controller)
+   * @param subscription (std::unique_ptr<Subscription>)
+   */
+  void subscribe(Controller* controller, std::unique_ptr<Subscription> subscription)
+  {
+    {
+      std::scoped_lock lock(mtx_);
+      subscription->next = std::chrono::steady_clock::now();
+      controller->subscriptions.push_back(std::move(subscription));
+    }
+    wake();
+  }
+
+  /**
+   * @brief Queue a command for writing
+   * @param controller (pointer to Controller)
+   * @param code (const reference to MSPCode)
+   * @param data (const reference to Bytes)
+   * @return True if the command was queued, False if the port is closed (bool)
+   */
+  bool send(Controller* controller, const MSPCode& code, const Bytes& data)
+  {
+    std::scoped_lock lock(mtx_);
+    if (!controller->open)
+    {
+      return false;
+    }
+    Parser::pack(controller->version, code, data.data(), data.size(), '<', controller->tx);
+    flush(*controller);
+    return true;
+  }
+
+  /// Mutex protecting the flight controllers, held by the loop except while calling the callbacks
+  std::mutex mtx_;
+
+ private:
+  /**
+   * @brief Wake the loop up, to reschedule it
+   */
+  void wake()
+  {
+    // An absolute time in the past fires right away
+    itimerspec spec = {};
+    spec.it_value.tv_nsec = 1;
+    ::timerfd_settime(tfd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+  }
+
+  /**
+   * @brief Event loop, run until stopped
+   */
+  void run()
+  {
+    std::unique_lock lock(mtx_);
+    epoll_event events[32];
+    while (active_)
+    {
+      lock.unlock();
+      const int n = ::epoll_wait(epfd_, events, 32, -1);
+      lock.lock();
+
+      for (int i = 0; i < n; ++i)
+      {
+        if (events[i].data.ptr == nullptr)
+        {
+          uint64_t expirations;
+          [[maybe_unused]] ssize_t r = ::read(tfd_, &expirations, sizeof(expirations));
+          continue;
+        }
+        Controller& controller = *static_cast<Controller*>(events[i].data.ptr);
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+        {
+          receive(controller, lock);
+        }
+        if ((events[i].events & EPOLLOUT) && controller.open)
+        {
+          flush(controller);
+        }
+      }
+
+      schedule();
+    }
+  }
+
+  /**
+   * @brief Queue the subscriptions due, time out the requests, issue the next requests and arm the timer for the
+   * next deadline
+   */
+  void schedule()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    for (auto& controller : controllers_)
+    {
+      if (!controller->open)
+      {
+        continue;
+      }
+
+      // Time out the request in flight
+      if (controller->in_flight && now - controller->sent > controller->timeout)
+      {
+        ++controller->stats.timeouts;
+        complete(*controller);
+      }
+
+      // Queue the subscriptions due, skipping the periods missed
+      for (auto& subscription : controller->subscriptions)
+      {
+        if (!subscription->pending && subscription->next <= now)
+        {
+          subscription->pending = true;
+          controller->queue.push_back(subscription.get());
+          subscription->next += subscription->period;
+          if (subscription->next <= now)
+          {
+            subscription->next = now + subscription->period;
+          }
+        }
+        if (!subscription->pending)
+        {
+          deadline = std::min(deadline, subscription->next);
+        }
+      }
+
+      request(*controller);
+      if (controller->in_flight)
+      {
+        deadline = std::min(deadline, controller->sent + controller->timeout);
+      }
+    }
+
+    // Arm the timer, or disarm it if nothing is due
+    itimerspec spec = {};
+    if (deadline != std::chrono::steady_clock::time_point::max())
+    {
+      const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+      spec.it_value.tv_sec = std::max<int64_t>(ns, 1) / 1000000000;
+      spec.it_value.tv_nsec = std::max<int64_t>(ns, 1) % 1000000000;
+    }
+    ::timerfd_settime(tfd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+  }
+
+  /**
+   * @brief Write the next queued request of a flight controller, if none is in flight
+   * @param controller (reference to Controller)
+   */
+  void request(Controller& controller)
+  {
+    if (controller.in_flight || controller.queue.empty())
+    {
+      return;
+    }
+    controller.in_flight = controller.queue.front();
+    controller.queue.pop_front();
+    controller.sent = std::chrono::steady_clock::now();
+    Parser::pack(controller.version, controller.in_flight->msg->getCode(), nullptr, 0, '<', controller.tx);
+    ++controller.stats.requests;
+    flush(controller);
+  }
+
+  /**
+   * @brief Complete the request in flight of a flight controller
+   * @param controller (reference to Controller)
+   */
+  void complete(Controller& controller)
+  {
+    controller.in_flight->pending = false;
+    controller.in_flight = nullptr;
+  }
+
+  /**
+   * @brief Read and parse everything available on a port, and dispatch the responses
+   * @param controller (reference to Controller)
+   * @param lock lock of the loop mutex, released while calling the callbacks (reference to std::unique_lock)
+   */
+  void receive(Controller& controller, std::unique_lock<std::mutex>& lock)
+  {
+    while (controller.open)
+    {
+      const ssize_t n = ::read(controller.fd, rx_buffer_, sizeof(rx_buffer_));
+      if (n <= 0)
+      {
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+          logger_->err("FleetManager: Port of flight controller " + std::to_string(controller.index) + " closed");
+          ::epoll_ctl(epfd_, EPOLL_CTL_DEL, controller.fd, nullptr);
+          controller.open = false;
+        }
+        return;
+      }
+
+      const uint8_t* data = rx_buffer_;
+      size_t size = static_cast<size_t>(n);
+      while (size > 0)
+      {
+        const size_t consumed = controller.parser.parse(data, size);
+        data += consumed;
+        size -= consumed;
+        if (controller.parser.ready())
+        {
+          dispatch(controller, controller.parser.frame(), lock);
+        }
+      }
+      controller.stats.crc_errors = controller.parser.getCrcErrors();
+
+      if (static_cast<size_t>(n) < sizeof(rx_buffer_))
+      {
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Dispatch a received frame to the subscription of the request in flight
+   * @param controller (reference to Controller)
+   * @param frame (const reference to Frame)
+   * @param lock lock of the loop mutex, released while calling the callback (reference to std::unique_lock)
+   */
+  void dispatch(Controller& controller, const Frame& frame, std::unique_lock<std::mutex>& lock)
+  {
+    // Discard the frames not answering the request in flight, e.g. acks of commands
+    Subscription* subscription = controller.in_flight;
+    if (frame.direction == '<' || !subscription || frame.code != subscription->msg->getCode())
+    {
+      ++controller.stats.discarded;
+      return;
+    }
+    controller.stats.latency.add(std::chrono::steady_clock::now() - controller.sent);
+    complete(controller);
+
+    // Issue the next request before decoding, to keep the link busy
+    request(controller);
+
+    if (frame.direction == '!')
+    {
+      ++controller.stats.errors;
+      return;
+    }
+    ++controller.stats.responses;
+    if (!subscription->msg->decodeMessage(frame.payload))
+    {
+      ++controller.stats.decode_errors;
+      return;
+    }
+
+    // The subscription is pending again only once rescheduled by this thread, its message is not touched meanwhile
+    lock.unlock();
+    subscription->callback(controller.index, *subscription->msg);
+    lock.lock();
+  }
+
+  /**
+   * @brief Write the queued bytes of a flight controller, until its port buffer is full
+   * @param controller (reference to Controller)
+   */
+  void flush(Controller& controller)
+  {
+    while (controller.tx_offset < controller.tx.size())
+    {
+      const ssize_t n = ::write(controller.fd, controller.tx.data() + controller.tx_offset,
+                                controller.tx.size() - controller.tx_offset);
+      if (n > 0)
+      {
+        controller.tx_offset += static_cast<size_t>(n);
+      }
+      else if (n == -1 && errno == EINTR)
+      {
+        continue;
+      }
+      else
+      {
+        // Wait for writability if the port buffer is full
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+          watchWritable(controller, true);
+        }
+        return;
+      }
+    }
+    controller.tx.clear();
+    controller.tx_offset = 0;
+    watchWritable(controller, false);
+  }
+
+  /**
+   * @brief Watch, or stop watching, the writability of a port
+   * @param controller (reference to Controller)
+   * @param writable (bool)
+   */
+  void watchWritable(Controller& controller, bool writable)
+  {
+    if (writable == controller.watching_writable || !controller.open)
+    {
+      return;
+    }
+    epoll_event event = {};
+    event.events = static_cast<uint32_t>(EPOLLIN) | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.ptr = &controller;
+    ::epoll_ctl(epfd_, EPOLL_CTL_MOD, controller.fd, &event);
+    controller.watching_writable = writable;
+  }
+
+  /// Shared pointer to logger
+  std::shared_ptr<Logger> logger_;
+
+  /// epoll and timer file descriptors
+  int epfd_ = -1;
+  int tfd_ = -1;
+
+  /// Loop thread, and flag to indicate wheater it is active
+  std::thread th_;
+  std::atomic_bool active_ = true;
+
+  /// Flight controllers of the loop
+  std::vector<std::unique_ptr<Controller>> controllers_;
+
+  /// Read buffer
+  uint8_t rx_buffer_[4096];
+};
+
+FleetManager::FleetManager(std::shared_ptr<Logger> logger, const size_t& loops, const bool& pin)
+    : logger_(std::move(logger))
+{
+  const size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  for (size_t i = 0; i < std::max<size_t>(loops, 1); ++i)
+  {
+    loops_.push_back(std::make_unique<Loop>(logger_, pin ? static_cast<int>(i % cores) : -1));
+  }
+}
+
+FleetManager::~FleetManager()
+{
+  // Stop the loops, before the flight controllers they own are destroyed
+  loops_.clear();
+}
+
+size_t FleetManager::add(const std::string& port, const uint32_t& baudrate, const MSPVer& ver)
+{
+  auto serial = std::make_unique<serial::Serial>(port, baudrate, serial::Timeout::simpleTimeout(0));
+  const int fd = serial->getFd();
+  return add(fd, std::move(serial), ver);
+}
+
+size_t FleetManager::add(int fd, const MSPVer& ver)
+{
+  return add(fd, nullptr, ver);
+}
+
+size_t FleetManager::add(int fd, std::unique_ptr<serial::Serial> serial, const MSPVer& ver)
+{
+  std::scoped_lock lock(fcs_mtx_);
+  const size_t index = fcs_.size();
+  Loop* loop = loops_.at(index % loops_.size()).get();
+  fcs_.emplace_back(loop, loop->add(index, fd, std::move(serial), ver, timeout_));
+  logger_->info("FleetManager: Flight controller " + std::to_string(index) + " added");
+  return index;
+}
+
+bool FleetManager::subscribe(const size_t& fc, float freq, Callback callback, std::unique_ptr<Msg> msg)
+{
+  if (!PeriodicCallback::isValidFrequency(freq))
+  {
+    logger_->err("FleetManager: Invalid subscription frequency " + std::to_string(freq));
+    return false;
+  }
+  auto [loop, controller] = find(fc);
+  auto subscription = std::make_unique<Subscription>();
+  subscription->period = std::chrono::nanoseconds(std::chrono::nanoseconds::rep(std::nano::den / freq));
+  subscription->msg = std::move(msg);
+  subscription->callback = std::move(callback);
+  loop->subscribe(controller, std::move(subscription));
+  return true;
+}
+
+bool FleetManager::send(const size_t& fc, const MSPCode& code, const Bytes& data)
+{
+  auto [loop, controller] = find(fc);
+  return loop->send(controller, code, data);
+}
+
+bool FleetManager::isOpen(const size_t& fc)
+{
+  auto [loop, controller] = find(fc);
+  std::scoped_lock lock(loop->mtx_);
+  return controller->open;
+}
+
+FleetStats FleetManager::getStats(const size_t& fc)
+{
+  auto [loop, controller] = find(fc);
+  std::scoped_lock lock(loop->mtx_);
+  return controller->stats;
+}
+
+size_t FleetManager::size()
+{
+  std::scoped_lock lock(fcs_mtx_);
+  return fcs_.size();
+}
+
+std::pair<FleetManager::Loop*, FleetManager::Controller*> FleetManager::find(const size_t& fc)
+{
+  std::scoped_lock lock(fcs_mtx_);
+  return fcs_.at(fc);
+}
+}  // namespace mspfci
\ No newline at end of file
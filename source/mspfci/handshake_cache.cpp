@@ -0,0 +1,127 @@
+#include "mspfci/handshake_cache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "mspfci/parser.hpp"
+
+namespace mspfci
+{
+/// Magic and version of the cache files
+static constexpr char cache_magic[4] = {'M', 'S', 'P', 'H'};
+static constexpr uint8_t cache_version = 1;
+
+HandshakeCache::HandshakeCache(std::shared_ptr<Logger> logger, const std::string& directory)
+    : logger_(std::move(logger)), directory_(directory)
+{
+}
+
+bool HandshakeCache::load(const BoardUid& uid, const FcVersion& version)
+{
+  payloads_.clear();
+  std::ifstream file(path(uid), std::ios::binary);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  const Bytes data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  // Header, and checksum of the whole file
+  const size_t header_size = sizeof(cache_magic) + 4;
+  if (data.size() < header_size + 1 || std::memcmp(data.data(), cache_magic, sizeof(cache_magic)) != 0 ||
+      Parser::crc8(0, data.data(), data.size() - 1) != data.back())
+  {
+    logger_->warn("HandshakeCache: Corrupted entry " + path(uid) + ", ignored");
+    return false;
+  }
+  if (data.at(4) != cache_version || data.at(5) != version.getMajor() || data.at(6) != version.getMinor() ||
+      data.at(7) != version.getPatch())
+  {
+    logger_->info("HandshakeCache: Stale entry " + path(uid) + ", ignored");
+    return false;
+  }
+
+  // Records
+  size_t offset = header_size;
+  while (offset + 4 <= data.size() - 1)
+  {
+    uint16_t code = 0;
+    uint16_t size = 0;
+    if (!decode(data, code, offset) || !decode(data, size, offset + 2) || offset + 4 + size > data.size() - 1)
+    {
+      break;
+    }
+    payloads_[static_cast<MSPCode>(code)] = Bytes(data.begin() + offset + 4, data.begin() + offset + 4 + size);
+    offset += 4 + size;
+  }
+  if (offset != data.size() - 1)
+  {
+    logger_->warn("HandshakeCache: Corrupted entry " + path(uid) + ", ignored");
+    payloads_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool HandshakeCache::store(const BoardUid& uid, const FcVersion& version)
+{
+  Bytes data(cache_magic, cache_magic + sizeof(cache_magic));
+  data.insert(data.end(), {cache_version, version.getMajor(), version.getMinor(), version.getPatch()});
+  for (const auto& [code, payload] : payloads_)
+  {
+    bool succeeded = encode(static_cast<uint16_t>(code), data);
+    succeeded &= encode(static_cast<uint16_t>(payload.size()), data);
+    if (!succeeded)
+    {
+      return false;
+    }
+    data.insert(data.end(), payload.begin(), payload.end());
+  }
+  data.push_back(Parser::crc8(0, data.data(), data.size()));
+
+  // Write a temporary file, then rename it over the previous one, so that readers never see a partial entry
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  const std::string tmp_path = path(uid) + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file.good())
+    {
+      logger_->err("HandshakeCache: Failed to write " + tmp_path);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmp_path, path(uid), ec);
+  if (ec)
+  {
+    logger_->err("HandshakeCache: Failed to write " + path(uid) + ": " + ec.message());
+    return false;
+  }
+  return true;
+}
+
+bool HandshakeCache::get(Msg& msg) const
+{
+  auto it = payloads_.find(msg.getCode());
+  return it != payloads_.end() && msg.decodeMessage(it->second);
+}
+
+bool HandshakeCache::set(Msg& msg)
+{
+  Bytes payload;
+  if (!msg.encodeMessage(payload))
+  {
+    return false;
+  }
+  payloads_[msg.getCode()] = std::move(payload);
+  return true;
+}
+
+std::string HandshakeCache::path(const BoardUid& uid) const
+{
+  return (std::filesystem::path(directory_) / (uid.str() + ".bin")).string();
+}
+}  // namespace mspfci
\ No newline at end of file
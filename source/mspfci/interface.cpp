@@ -1,123 +1,608 @@
 #include "mspfci/interface.hpp"
 
+#include <algorithm>
+#include <filesystem>
+
 namespace mspfci
 {
-Interface::Interface(const std::string& port, const uint32_t& baudrate, const MSPVer& ver, const LoggerLevel& level)
-    : logger_(std::make_shared<Logger>(level)), msp_(std::make_shared<MSP>(logger_, port, baudrate, ver))
+Interface::Interface(const std::string& port,
+                     const uint32_t& baudrate,
+                     const MSPVer& ver,
+                     const LoggerLevel& level,
+                     const bool& wait,
+                     const std::string& cache)
+    : Interface(std::make_unique<SerialTransport>(port, baudrate), ver, level, wait, cache)
+{
+}
+
+Interface::Interface(std::unique_ptr<Transport> transport,
+                     const MSPVer& ver,
+                     const LoggerLevel& level,
+                     const bool& wait,
+                     const std::string& cache)
+    : logger_(std::make_shared<Logger>(level))
+    , msp_(std::make_shared<MSP>(logger_, std::move(transport), ver))
+    , engine_(std::make_shared<Engine>(logger_, msp_))
+    , rc_stream_(std::make_unique<RCStream>(logger_, engine_))
+    , dataflash_(std::make_unique<DataflashDownloader>(logger_, engine_))
+    , config_(std::make_unique<ConfigManager>(logger_, engine_))
+    , ready_future_(ready_promise_.get_future().share())
+    , construction_time_(std::chrono::steady_clock::now())
 {
-  // Register AUX map
-  logger_->info("Registering AUX map...");
-  while (!registerAuxMap())
+  if (!cache.empty())
   {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    cache_ = std::make_unique<HandshakeCache>(logger_, cache);
   }
+  // Initialize asynchronously
+  init_th_ = std::thread([this]() { initialize(); });
+  if (wait)
+  {
+    ready_future_.wait();
+  }
+}
 
-  // Reset RC channels
-  logger_->info("Resetting RC Channels...");
-  while (!resetRC())
+Interface::~Interface()
+{
+  {
+    std::scoped_lock lock(init_mtx_);
+    init_active_ = false;
+  }
+  init_cv_.notify_one();
+  if (init_th_.joinable())
+  {
+    init_th_.join();
+  }
+  stopReconnect();
+  if (port_watcher_)
   {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    port_watcher_->removeCallback(port_watch_id_);
   }
 }
 
-bool Interface::read(Msg& msg)
+void Interface::enableReconnect(std::shared_ptr<PortWatcher> watcher)
 {
-  Bytes raw_data;
+  stopReconnect();
+
+  // Wake the reconnection up on the events of the port
+  std::error_code ec;
+  const std::string port = std::filesystem::weakly_canonical(msp_->getPort(), ec).string();
+  if (watcher)
+  {
+    reconnect_watcher_ = watcher;
+    reconnect_watch_id_ =
+        reconnect_watcher_->addCallback([this, port](const PortEvent&, const serial::PortInfo& info) {
+          if (info.port == port)
+          {
+            {
+              std::scoped_lock lock(reconnect_mtx_);
+              port_event_ = true;
+            }
+            reconnect_cv_.notify_one();
+          }
+        });
+  }
+
+  reconnect_active_ = true;
+  reconnect_th_ = std::thread([this, watcher = std::move(watcher)]() { reconnect(watcher); });
+}
+
+void Interface::stopReconnect()
+{
+  {
+    std::scoped_lock lock(reconnect_mtx_);
+    reconnect_active_ = false;
+  }
+  reconnect_cv_.notify_one();
+  if (reconnect_th_.joinable())
+  {
+    reconnect_th_.join();
+  }
+  if (reconnect_watcher_)
+  {
+    reconnect_watcher_->removeCallback(reconnect_watch_id_);
+    reconnect_watcher_ = nullptr;
+  }
+}
 
+LatencyStats Interface::getRecoveryTime()
+{
+  std::scoped_lock lock(recovery_mtx_);
+  return recovery_;
+}
+
+size_t Interface::addSubscription(std::unique_ptr<Msg> msg, std::unique_ptr<Subscriber> subscriber, float freq)
+{
+  if (!PeriodicCallback::isValidFrequency(freq))
   {
-    std::scoped_lock lock(msp_->msp_mtx_);
+    logger_->err("Invalid subscription frequency " + std::to_string(freq));
+    return invalid_subscription;
+  }
+
+  std::scoped_lock lock(pcs_mtx_);
 
-    if (!msp_->send(msg.getCode(), mspfci::Bytes()))
+  // Periodic callback of the message, shared by its subscriptions
+  auto& pc = pcs_[std::type_index(typeid(*msg))];
+  if (!pc)
+  {
+    const std::string name = "periodic callback of code " + std::to_string(static_cast<uint16_t>(msg->getCode()));
+    pc = std::make_shared<PeriodicCallback>(logger_, engine_, std::move(msg));
+    if (realtime_)
     {
-      logger_->err("Failed to send command");
-      return false;
+      [[maybe_unused]] const bool succeeded = configureThread(
+          logger_, pc->getNativeHandle(), name, realtime_->policy, realtime_->callback_priority, realtime_->callback_cores);
     }
+  }
+  pc->add(next_pc_id_, std::move(subscriber), freq);
+  subscriptions_.emplace(next_pc_id_, pc);
+  return next_pc_id_++;
+}
+
+bool Interface::setRealtime(const RealtimeConfig& config)
+{
+  bool succeeded = true;
+  if (config.lock_memory)
+  {
+    succeeded &= lockMemory(logger_, config.prefault_heap);
+  }
+  const bool realtime = config.policy == SCHED_FIFO || config.policy == SCHED_RR;
+  msp_->setSpinTime(realtime ? config.spin_time : std::chrono::nanoseconds::max());
+  succeeded &=
+      configureThread(logger_, engine_->getNativeHandle(), "engine", config.policy, config.io_priority, config.io_cores);
+  succeeded &= configureThread(logger_, rc_stream_->getNativeHandle(), "RC stream", config.policy, config.io_priority,
+                               config.io_cores);
+
+  std::scoped_lock lock(pcs_mtx_);
+  realtime_ = config;
+  for (const auto& [type, pc] : pcs_)
+  {
+    succeeded &= configureThread(logger_, pc->getNativeHandle(), "periodic callback", config.policy,
+                                 config.callback_priority, config.callback_cores);
+  }
+  if (succeeded)
+  {
+    logger_->info("Real-time configuration applied");
+  }
+  return succeeded;
+}
+
+PeriodicCallback* Interface::findSubscription(const size_t& id)
+{
+  auto it = subscriptions_.find(id);
+  return it == subscriptions_.end() ? nullptr : it->second.get();
+}
 
-    if (!msp_->receive(raw_data))
+bool Interface::unsubscribe(const size_t& id)
+{
+  std::shared_ptr<PeriodicCallback> pc;
+  {
+    std::scoped_lock lock(pcs_mtx_);
+    auto it = subscriptions_.find(id);
+    if (it == subscriptions_.end())
     {
-      logger_->err("Failed to receive data");
       return false;
     }
+    pc = std::move(it->second);
+    subscriptions_.erase(it);
   }
 
-  if (!msg.decodeMessage(raw_data))
+  // Remove out of the lock, as it waits for the delivery in progress, whose callbacks may use the interface. The
+  // periodic callback is stopped once its last subscription is removed, unless subscribed again meanwhile
+  if (pc->remove(id))
+  {
+    std::scoped_lock lock(pcs_mtx_);
+    const bool subscribed = std::any_of(subscriptions_.begin(), subscriptions_.end(),
+                                        [&pc](const auto& subscription) { return subscription.second == pc; });
+    if (!subscribed)
+    {
+      std::erase_if(pcs_, [&pc](const auto& entry) { return entry.second == pc; });
+    }
+  }
+  return true;
+}
+
+bool Interface::pauseSubscription(const size_t& id)
+{
+  std::scoped_lock lock(pcs_mtx_);
+  PeriodicCallback* pc = findSubscription(id);
+  if (!pc)
   {
-    logger_->err("Failed to decode data");
     return false;
   }
+  pc->pause(id);
+  return true;
+}
 
+bool Interface::resumeSubscription(const size_t& id)
+{
+  std::scoped_lock lock(pcs_mtx_);
+  PeriodicCallback* pc = findSubscription(id);
+  if (!pc)
+  {
+    return false;
+  }
+  pc->resume(id);
   return true;
 }
 
-bool Interface::registerAuxMap()
+bool Interface::setSubscriptionFrequency(const size_t& id, float freq)
 {
-  if (read(rx_map_))
+  std::scoped_lock lock(pcs_mtx_);
+  PeriodicCallback* pc = findSubscription(id);
+  if (!pc || !PeriodicCallback::isValidFrequency(freq))
   {
-    logger_->info(rx_map_);
-    return true;
+    return false;
   }
-  else
+  pc->setFrequency(id, freq);
+  return true;
+}
+
+bool Interface::setSubscriptionAdaptive(const size_t& id, float min_freq, float max_freq)
+{
+  std::scoped_lock lock(pcs_mtx_);
+  PeriodicCallback* pc = findSubscription(id);
+  if (!pc || !PeriodicCallback::isValidFrequency(min_freq) || !PeriodicCallback::isValidFrequency(max_freq) ||
+      min_freq > max_freq)
   {
     return false;
   }
+  pc->setAdaptive(id, min_freq, max_freq);
+  return true;
 }
 
-bool Interface::resetRC()
+float Interface::getSubscriptionFrequency(const size_t& id)
 {
-  mspfci::RCRawIn rc;
+  std::scoped_lock lock(pcs_mtx_);
+  PeriodicCallback* pc = findSubscription(id);
+  return pc ? pc->getFrequency(id) : 0.0f;
+}
 
-  while (!read(rc))
+RateStats Interface::getSubscriptionRateStats(const size_t& id)
+{
+  std::scoped_lock lock(pcs_mtx_);
+  PeriodicCallback* pc = findSubscription(id);
+  return pc ? pc->getRateStats() : RateStats();
+}
+
+LatencyStats Interface::getSubscriptionJitter(const size_t& id)
+{
+  std::scoped_lock lock(pcs_mtx_);
+  PeriodicCallback* pc = findSubscription(id);
+  return pc ? pc->getJitter() : LatencyStats();
+}
+
+void Interface::reconnect(std::shared_ptr<PortWatcher> watcher)
+{
+  std::error_code ec;
+  const std::string port = std::filesystem::weakly_canonical(msp_->getPort(), ec).string();
+  const std::chrono::milliseconds min_backoff(10);
+  const std::chrono::milliseconds max_backoff(100);
+  std::chrono::milliseconds backoff = min_backoff;
+  bool lost = false;
+  std::chrono::steady_clock::time_point lost_time;
+
+  std::unique_lock lock(reconnect_mtx_);
+  while (reconnect_active_)
   {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    // Wait for the backoff, or for an event of the port
+    reconnect_cv_.wait_for(lock, backoff, [this]() { return !reconnect_active_ || port_event_; });
+    if (!reconnect_active_)
+    {
+      break;
+    }
+    port_event_ = false;
+    lock.unlock();
+
+    {
+      std::scoped_lock msp_lock(msp_->msp_mtx_);
+
+      // Close the port as soon as the device is removed, rather than on the next I/O error
+      if (watcher && !watcher->isPresent(port) && msp_->isOpen())
+      {
+        msp_->close();
+      }
+
+      if (!msp_->isOpen())
+      {
+        if (!lost)
+        {
+          lost = true;
+          lost_time = std::chrono::steady_clock::now();
+          logger_->warn("Connection lost on port " + msp_->getPort() + ", reconnecting");
+        }
+
+        // Reopen, as soon as the port is back if watched
+        if ((!watcher || watcher->isPresent(port)) && msp_->reopen())
+        {
+          const std::chrono::nanoseconds recovery = std::chrono::steady_clock::now() - lost_time;
+          {
+            std::scoped_lock recovery_lock(recovery_mtx_);
+            recovery_.add(recovery);
+          }
+          logger_->info("Reconnected in " + std::to_string(recovery.count() / 1000000) + " ms");
+          lost = false;
+          backoff = min_backoff;
+        }
+        else
+        {
+          backoff = std::min(backoff * 2, max_backoff);
+        }
+      }
+    }
+
+    lock.lock();
   }
+}
 
-  rc_raw_out_.channels(std::vector<uint16_t>(rc.channels().size(), 1500));
-  if (!rc_raw_out_.channel(rx_map_.getMap().at(3), 1000))
+void Interface::watchPort(std::shared_ptr<PortWatcher> watcher, std::function<void(const PortEvent&)> callback)
+{
+  if (port_watcher_)
   {
-    return false;
+    port_watcher_->removeCallback(port_watch_id_);
   }
 
-  mspfci::Bytes msg;
+  // Match the events against the device node, the port may be a symlink (e.g. /dev/serial/by-id/...)
+  std::error_code ec;
+  const std::string port = std::filesystem::weakly_canonical(msp_->getPort(), ec).string();
+  port_watcher_ = std::move(watcher);
+  port_watch_id_ = port_watcher_->addCallback(
+      [port, callback = std::move(callback)](const PortEvent& event, const serial::PortInfo& info) {
+        if (info.port == port)
+        {
+          callback(event);
+        }
+      });
+}
+
+bool Interface::read(Msg& msg)
+{
+  Bytes raw_data;
+
+  if (!engine_->request(msg.getCode(), mspfci::Bytes(), raw_data, Priority::TELEMETRY))
+  {
+    logger_->err("Failed to receive data");
+    return false;
+  }
 
-  if (!rc_raw_out_.encodeMessage(msg))
+  if (!msg.decodeMessage(raw_data))
   {
+    logger_->err("Failed to decode data");
     return false;
   }
 
+  return true;
+}
+
+void Interface::onReady(std::function<void()> callback)
+{
   {
-    std::scoped_lock lock(msp_->msp_mtx_);
-    if (!msp_->send(rc_raw_out_.getCode(), msg))
+    std::scoped_lock lock(init_mtx_);
+    if (!ready_)
     {
-      return false;
+      ready_callbacks_.push_back(std::move(callback));
+      return;
     }
   }
-
-  return true;
+  callback();
 }
 
-bool Interface::setRC()
+void Interface::initialize()
 {
-  mspfci::Bytes msg;
+  logger_->info("Initializing");
+  std::chrono::milliseconds delay(10);
+  const size_t max_attempts = 3;
 
-  if (!rc_raw_out_.encodeMessage(msg))
+  // Identify the board, and start from its cached handshake
+  std::optional<BoardUid> uid;
+  std::optional<FcVersion> fc_version;
+  for (size_t attempt = 0; cache_ && !(uid && fc_version) && attempt < max_attempts; ++attempt)
   {
-    return false;
+    if (attempt > 0 && !backoff(delay))
+    {
+      return;
+    }
+    std::future<std::optional<BoardUid>> uid_future;
+    std::future<std::optional<FcVersion>> fc_version_future;
+    if (!uid)
+    {
+      uid_future = readFuture<BoardUid>();
+    }
+    if (!fc_version)
+    {
+      fc_version_future = readFuture<FcVersion>();
+    }
+    if (uid_future.valid())
+    {
+      uid = uid_future.get();
+    }
+    if (fc_version_future.valid())
+    {
+      fc_version = fc_version_future.get();
+    }
+  }
+  const bool identified = uid && fc_version;
+  if (cache_ && !identified)
+  {
+    logger_->warn("Board not identified, handshake cache disabled");
+  }
+  std::optional<ApiVersion> cached_api_version;
+  if (identified && cache_->load(*uid, *fc_version))
+  {
+    RXMap cached_rx_map;
+    RCRawIn cached_rc;
+    ApiVersion api_version;
+    if (cache_->get(api_version))
+    {
+      cached_api_version = api_version;
+    }
+    if (cache_->get(cached_rx_map) && cache_->get(cached_rc))
+    {
+      logger_->info("Board " + uid->str() + " (firmware " + fc_version->str() + ") found in the handshake cache");
+      setReady(cached_rx_map, cached_rc, cached_api_version);
+    }
   }
 
+  // Query, or refresh, the handshake
+  delay = std::chrono::milliseconds(10);
+  std::optional<RXMap> rx_map;
+  std::optional<RCRawIn> rc;
+  std::optional<ApiVersion> api_version = cached_api_version;
+  size_t api_version_attempts = 0;
+  while (true)
   {
-    std::scoped_lock lock(msp_->msp_mtx_);
+    // Queue the pending queries together, the engine pipelines them
+    std::future<std::optional<RXMap>> rx_map_future;
+    std::future<std::optional<RCRawIn>> rc_future;
+    std::future<std::optional<ApiVersion>> api_version_future;
+    if (!rx_map)
+    {
+      rx_map_future = readFuture<RXMap>();
+    }
+    if (!rc)
+    {
+      rc_future = readFuture<RCRawIn>();
+    }
+    if (!api_version && api_version_attempts < max_attempts)
+    {
+      api_version_future = readFuture<ApiVersion>();
+      ++api_version_attempts;
+    }
+    if (rx_map_future.valid())
+    {
+      rx_map = rx_map_future.get();
+    }
+    if (rc_future.valid())
+    {
+      rc = rc_future.get();
+    }
+    if (api_version_future.valid())
+    {
+      api_version = api_version_future.get();
+
+      // Negotiate the MSP version: while the API version is not answered, try the other one. Once answered, the
+      // version is settled
+      if (!api_version && api_version_attempts < max_attempts)
+      {
+        std::scoped_lock lock(msp_->msp_mtx_);
+        msp_->setMspVersion(msp_->getMspVersion() == MSPVer::MSPv1 ? MSPVer::MSPv2 : MSPVer::MSPv1);
+      }
+    }
 
-    if (!msp_->send(rc_raw_out_.getCode(), msg))
+    // Done, the API version is optional
+    if (rx_map && rc && (api_version || api_version_attempts == max_attempts))
     {
-      return false;
+      break;
+    }
+
+    // Retry the failed queries
+    if (!backoff(delay))
+    {
+      return;
     }
   }
 
-  return true;
+  if (!ready_)
+  {
+    setReady(*rx_map, *rc, api_version);
+  }
+  else
+  {
+    // The cached RX map or channel count is outdated, apply the current ones, the RC channels set from the cached
+    // layout being meaningless with the current one
+    bool outdated;
+    {
+      std::scoped_lock lock(rc_mtx_);
+      outdated = rx_map->getMap() != rx_map_.getMap() || rc->channels().size() != rc_raw_out_.channels().size();
+    }
+    if (outdated)
+    {
+      logger_->warn("RX map changed since cached");
+      if (!resetRC(*rx_map, rc->channels().size()))
+      {
+        logger_->err("Failed to reset RC channels");
+      }
+    }
+  }
+
+  // Refresh the cache entry
+  if (identified)
+  {
+    bool succeeded = cache_->set(*rx_map) & cache_->set(*rc);
+    if (api_version)
+    {
+      succeeded &= cache_->set(*api_version);
+    }
+    if (!succeeded || !cache_->store(*uid, *fc_version))
+    {
+      logger_->err("Failed to store the handshake cache");
+    }
+  }
+}
+
+bool Interface::backoff(std::chrono::milliseconds& backoff)
+{
+  std::unique_lock lock(init_mtx_);
+  init_cv_.wait_for(lock, backoff, [this]() { return !init_active_; });
+  backoff = std::min(backoff * 2, std::chrono::milliseconds(100));
+  return init_active_;
+}
+
+void Interface::setReady(const RXMap& rx_map, const RCRawIn& rc, const std::optional<ApiVersion>& api_version)
+{
+  logger_->info(rx_map);
+  if (api_version)
+  {
+    api_version_ = *api_version;
+    logger_->info(api_version_);
+  }
+  else
+  {
+    logger_->warn("API version not available");
+  }
+
+  // Reset RC channels
+  if (!resetRC(rx_map, rc.channels().size()))
+  {
+    logger_->err("Failed to reset RC channels");
+  }
+
+  // Ready
+  startup_time_ = std::chrono::steady_clock::now() - construction_time_;
+  logger_->info("Ready in " + std::to_string(startup_time_.count() / 1000) + " us");
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::scoped_lock lock(init_mtx_);
+    ready_ = true;
+    callbacks.swap(ready_callbacks_);
+  }
+  ready_promise_.set_value();
+  for (const auto& callback : callbacks)
+  {
+    callback();
+  }
+}
+
+bool Interface::resetRC(const RXMap& rx_map, const size_t& channels)
+{
+  std::scoped_lock lock(rc_mtx_);
+  rx_map_ = rx_map;
+  rc_raw_out_.channels(std::vector<uint16_t>(channels, 1500));
+  return rc_raw_out_.channel(rx_map_.getMap().at(3), 1000) && setRC();
+}
+
+bool Interface::setRC()
+{
+  // Published even while the link is down, so that the latest channels (e.g. disarmed) are sent once it is back
+  return rc_stream_->set(rc_raw_out_.channels()) && rc_stream_->isLinkUp();
 }
 
 bool Interface::arm()
 {
+  if (!ready_)
+  {
+    logger_->err("Interface not ready");
+    return false;
+  }
+  std::scoped_lock lock(rc_mtx_);
   bool succeded = true;
   succeded &= rc_raw_out_.channel(rx_map_.getMap().at(4), 1000);
   succeded &= setRC();
@@ -126,6 +611,12 @@ bool Interface::arm()
 
 bool Interface::disarm()
 {
+  if (!ready_)
+  {
+    logger_->err("Interface not ready");
+    return false;
+  }
+  std::scoped_lock lock(rc_mtx_);
   bool succeded = true;
   succeded &= rc_raw_out_.channel(rx_map_.getMap().at(4), 2000);
   succeded &= setRC();
@@ -134,6 +625,12 @@ bool Interface::disarm()
 
 bool Interface::trpy(const uint16_t& throttle, const uint16_t& roll, const uint16_t& pitch, const uint16_t& yaw)
 {
+  if (!ready_)
+  {
+    logger_->err("Interface not ready");
+    return false;
+  }
+  std::scoped_lock lock(rc_mtx_);
   bool succeded = true;
   succeded &= rc_raw_out_.channel(rx_map_.getMap().at(0), roll);
   succeded &= rc_raw_out_.channel(rx_map_.getMap().at(1), pitch);
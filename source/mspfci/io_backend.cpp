@@ -0,0 +1,889 @@
+#include "mspfci/io_backend.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace mspfci
+{
+/**
+ * @brief Event loop driving the file descriptor of the port. The received bytes are pushed into a single producer
+ * single consumer ring read by the transport, and the frames written by the transport are queued until the loop
+ * writes them.
+ */
+class IoLoop
+{
+ public:
+  /**
+   * @brief Constructor
+   * @param fd file descriptor of the port (int)
+   */
+  explicit IoLoop(int fd) : fd_(fd), rx_(ring_capacity)
+  {
+    efd_ = ::eventfd(0, EFD_CLOEXEC);
+    if (efd_ == -1)
+    {
+      throw std::runtime_error(std::string("Failed to create eventfd: ") + strerror(errno));
+    }
+    tx_pending_.reserve(tx_capacity);
+  }
+
+  /**
+   * @brief Destructor, the loop has to be stopped by the derived class
+   */
+  virtual ~IoLoop() { ::close(efd_); }
+
+  /**
+   * @brief Getter. Get the backend
+   * @return backend (IoBackend)
+   */
+  virtual IoBackend backend() const = 0;
+
+  /**
+   * @brief Start the event loop thread
+   */
+  void start()
+  {
+    th_ = std::thread([this]() { run(); });
+  }
+
+  /**
+   * @brief Stop the event loop thread and wait for it
+   */
+  void stop()
+  {
+    if (active_.exchange(false))
+    {
+      wake();
+    }
+    if (th_.joinable())
+    {
+      th_.join();
+    }
+  }
+
+  /**
+   * @brief Get the number of received bytes not yet read
+   * @return number of bytes (size_t)
+   */
+  size_t available() const
+  {
+    return rx_head_.load(std::memory_order_acquire) - rx_tail_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Read received bytes
+   * @param buffer (pointer to uint8_t)
+   * @param size (size_t)
+   * @return number of bytes read (size_t)
+   */
+  size_t read(uint8_t* buffer, size_t size)
+  {
+    const size_t tail = rx_tail_.load(std::memory_order_relaxed);
+    const size_t bytes_read = std::min(size, rx_head_.load(std::memory_order_acquire) - tail);
+    for (size_t i = 0; i < bytes_read; ++i)
+    {
+      buffer[i] = rx_[(tail + i) & (ring_capacity - 1)];
+    }
+    rx_tail_.store(tail + bytes_read, std::memory_order_seq_cst);
+
+    // The loop stopped receiving while the ring was full, resume it
+    if (bytes_read > 0 && rx_blocked_.exchange(false))
+    {
+      wake();
+    }
+    return bytes_read;
+  }
+
+  /**
+   * @brief Queue bytes to be written, and wake the loop up if nothing was queued already
+   * @param buffers (pointer to const ConstBuffer)
+   * @param count (size_t)
+   * @return number of bytes queued (size_t)
+   */
+  size_t write(const ConstBuffer* buffers, size_t count)
+  {
+    if (!open_)
+    {
+      return 0;
+    }
+    size_t bytes_written = 0;
+    bool was_empty;
+    {
+      std::scoped_lock lock(tx_mtx_);
+      was_empty = tx_pending_.empty();
+      for (size_t i = 0; i < count; ++i)
+      {
+        tx_pending_.insert(tx_pending_.end(), buffers[i].data, buffers[i].data + buffers[i].size);
+        bytes_written += buffers[i].size;
+      }
+    }
+    ++frames_;
+
+    // Frames queued while the loop is busy are written together with a single wake up
+    if (was_empty)
+    {
+      wake();
+    }
+    return bytes_written;
+  }
+
+  /// Flag to indicate wheater the port is open
+  std::atomic_bool open_ = true;
+
+  /// Counters
+  std::atomic<uint64_t> syscalls_ = 0;
+  std::atomic<uint64_t> frames_ = 0;
+
+ protected:
+  /// Capacity of the receive ring and of the write buffer
+  static constexpr size_t ring_capacity = 65536;
+  static constexpr size_t tx_capacity = 65536;
+
+  /**
+   * @brief Event loop, run until stopped
+   */
+  virtual void run() = 0;
+
+  /**
+   * @brief Wake the event loop up
+   */
+  void wake()
+  {
+    const uint64_t one = 1;
+    [[maybe_unused]] ssize_t n = ::write(efd_, &one, sizeof(one));
+    ++syscalls_;
+  }
+
+  /**
+   * @brief Get the free space of the receive ring, the size of the next receive. Once the ring is full, the loop stops
+   * receiving (the bytes stay in the port buffer) until the transport reads and wakes it up
+   * @return free space, zero if full (size_t)
+   */
+  size_t space()
+  {
+    const size_t head = rx_head_.load(std::memory_order_relaxed);
+    size_t used = head - rx_tail_.load(std::memory_order_acquire);
+    if (used == ring_capacity)
+    {
+      // Full, flag it then check again, as the transport may have read meanwhile
+      rx_blocked_ = true;
+      used = head - rx_tail_.load(std::memory_order_seq_cst);
+      if (used < ring_capacity)
+      {
+        rx_blocked_ = false;
+      }
+    }
+    return ring_capacity - used;
+  }
+
+  /**
+   * @brief Push received bytes to the receive ring, never more than its free space
+   * @param data (pointer to const uint8_t)
+   * @param size (size_t)
+   */
+  void push(const uint8_t* data, size_t size)
+  {
+    const size_t head = rx_head_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < size; ++i)
+    {
+      rx_[(head + i) & (ring_capacity - 1)] = data[i];
+    }
+    rx_head_.store(head + size, std::memory_order_release);
+  }
+
+  /**
+   * @brief Take the queued bytes to be written
+   * @param buffer (pointer to uint8_t)
+   * @param capacity (size_t)
+   * @return number of bytes taken (size_t)
+   */
+  size_t take(uint8_t* buffer, size_t capacity)
+  {
+    std::scoped_lock lock(tx_mtx_);
+    const size_t size = std::min(capacity, tx_pending_.size());
+    std::copy(tx_pending_.begin(), tx_pending_.begin() + size, buffer);
+    tx_pending_.erase(tx_pending_.begin(), tx_pending_.begin() + size);
+    return size;
+  }
+
+  /// File descriptors of the port and of the wake up event
+  int fd_;
+  int efd_;
+
+  /// Flag to indicate wheater the loop is active
+  std::atomic_bool active_ = true;
+
+ private:
+  /// Event loop thread
+  std::thread th_;
+
+  /// Receive ring
+  Bytes rx_;
+  alignas(64) std::atomic<size_t> rx_head_ = 0;
+  alignas(64) std::atomic<size_t> rx_tail_ = 0;
+
+  /// Flag to indicate wheater the loop stopped receiving as the ring was full
+  std::atomic_bool rx_blocked_ = false;
+
+  /// Queued bytes to be written, protected by mutex
+  Bytes tx_pending_;
+  std::mutex tx_mtx_;
+};
+
+/**
+ * @brief epoll event loop. Non-blocking reads on readability, and writes until the port buffer is full
+ */
+class EpollLoop final : public IoLoop
+{
+ public:
+  explicit EpollLoop(int fd) : IoLoop(fd), rx_buffer_(4096), tx_buffer_(tx_capacity)
+  {
+    ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK);
+
+    // Both the port and the eventfd must be watched, the loop could not be woken up otherwise. The destructor does
+    // not run if the setup fails, the epoll instance is closed here
+    epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd_;
+    epoll_event wake_event = {};
+    wake_event.events = EPOLLIN;
+    wake_event.data.fd = efd_;
+    if (epfd_ == -1 || ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd_, &event) == -1 ||
+        ::epoll_ctl(epfd_, EPOLL_CTL_ADD, efd_, &wake_event) == -1)
+    {
+      const std::string error = strerror(errno);
+      if (epfd_ != -1)
+      {
+        ::close(epfd_);
+      }
+      throw std::runtime_error("Failed to set up epoll: " + error);
+    }
+    start();
+  }
+
+  ~EpollLoop()
+  {
+    stop();
+    ::close(epfd_);
+  }
+
+  IoBackend backend() const override { return IoBackend::EPOLL; }
+
+ protected:
+  void run() override
+  {
+    epoll_event events[2];
+    while (active_)
+    {
+      const int n = ::epoll_wait(epfd_, events, 2, -1);
+      ++syscalls_;
+      for (int i = 0; i < n; ++i)
+      {
+        if (events[i].data.fd == efd_)
+        {
+          uint64_t value;
+          [[maybe_unused]] ssize_t r = ::read(efd_, &value, sizeof(value));
+          ++syscalls_;
+          flush();
+          if (!watching_readable_)
+          {
+            receive();
+          }
+        }
+        else
+        {
+          if (events[i].events & EPOLLIN)
+          {
+            receive();
+          }
+          if (events[i].events & EPOLLOUT)
+          {
+            flush();
+          }
+          if ((events[i].events & (EPOLLHUP | EPOLLERR)) && !(events[i].events & EPOLLIN))
+          {
+            open_ = false;
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  /**
+   * @brief Read everything available, as long as the receive ring has space, stop watching the readability otherwise
+   */
+  void receive()
+  {
+    while (true)
+    {
+      const size_t size = std::min(space(), rx_buffer_.size());
+      setInterest(size > 0, watching_writable_);
+      if (size == 0)
+      {
+        return;
+      }
+      const ssize_t n = ::read(fd_, rx_buffer_.data(), size);
+      ++syscalls_;
+      if (n > 0)
+      {
+        push(rx_buffer_.data(), static_cast<size_t>(n));
+        if (static_cast<size_t>(n) < size)
+        {
+          return;
+        }
+      }
+      else
+      {
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+          open_ = false;
+        }
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Write the queued bytes, until the port buffer is full
+   */
+  void flush()
+  {
+    while (true)
+    {
+      if (tx_offset_ == tx_size_)
+      {
+        tx_offset_ = 0;
+        tx_size_ = take(tx_buffer_.data(), tx_buffer_.size());
+        if (tx_size_ == 0)
+        {
+          setInterest(watching_readable_, false);
+          return;
+        }
+      }
+
+      const ssize_t n = ::write(fd_, tx_buffer_.data() + tx_offset_, tx_size_ - tx_offset_);
+      ++syscalls_;
+      if (n > 0)
+      {
+        tx_offset_ += static_cast<size_t>(n);
+      }
+      else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      {
+        // Wait for writability
+        setInterest(watching_readable_, true);
+        return;
+      }
+      else if (n == -1 && errno == EINTR)
+      {
+        continue;
+      }
+      else
+      {
+        open_ = false;
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Watch, or stop watching, the readability and the writability of the port
+   * @param readable (bool)
+   * @param writable (bool)
+   */
+  void setInterest(bool readable, bool writable)
+  {
+    if (readable == watching_readable_ && writable == watching_writable_)
+    {
+      return;
+    }
+    epoll_event event = {};
+    event.events = (readable ? static_cast<uint32_t>(EPOLLIN) : 0u) | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.fd = fd_;
+    ::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd_, &event);
+    ++syscalls_;
+    watching_readable_ = readable;
+    watching_writable_ = writable;
+  }
+
+  /// epoll file descriptor
+  int epfd_ = -1;
+
+  /// Read buffer
+  Bytes rx_buffer_;
+
+  /// Bytes being written
+  Bytes tx_buffer_;
+  size_t tx_offset_ = 0;
+  size_t tx_size_ = 0;
+  bool watching_readable_ = true;
+  bool watching_writable_ = false;
+};
+
+/**
+ * @brief io_uring event loop, through the raw system calls. A read into a registered buffer is always posted, as well
+ * as a read of the wake up event. Queued bytes are written with a single write into a registered buffer, submitted
+ * along with the wait for completions
+ */
+class UringLoop final : public IoLoop
+{
+ public:
+  /**
+   * @brief Check if io_uring is available
+   * @return True if an io_uring instance can be created, False otherwise (bool)
+   */
+  static bool available()
+  {
+    io_uring_params params = {};
+    const int fd = static_cast<int>(::syscall(__NR_io_uring_setup, 4, &params));
+    if (fd == -1)
+    {
+      return false;
+    }
+    ::close(fd);
+    return true;
+  }
+
+  explicit UringLoop(int fd) : IoLoop(fd), rx_buffer_(4096), tx_buffer_(tx_capacity)
+  {
+    // Reads are completed by io_uring when data arrives, the file must be blocking
+    ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_NONBLOCK);
+
+    try
+    {
+      setup();
+    }
+    catch (const std::exception&)
+    {
+      release();
+      throw;
+    }
+    startRead();
+    post(IORING_OP_READ, efd_, &wake_value_, sizeof(wake_value_), 0, wake_tag);
+    start();
+  }
+
+  ~UringLoop()
+  {
+    stop();
+    release();
+  }
+
+  IoBackend backend() const override { return IoBackend::IO_URING; }
+
+ protected:
+  void run() override
+  {
+    while (active_ || in_flight_ > 0)
+    {
+      // Once stopped, cancel the pending operations and wait for them, as they target buffers owned by the loop
+      if (!active_ && !cancelled_)
+      {
+        cancel(rx_tag);
+        cancel(wake_tag);
+        cancel(tx_tag);
+        cancelled_ = true;
+      }
+
+      // Submit and wait with a single system call
+      const int n = static_cast<int>(
+          ::syscall(__NR_io_uring_enter, ring_fd_, to_submit_, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+      ++syscalls_;
+      if (n >= 0)
+      {
+        to_submit_ -= static_cast<unsigned>(n);
+      }
+      else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      {
+        open_ = false;
+        break;
+      }
+
+      // Reap the completions
+      unsigned head = *cq_head_;
+      const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head)
+      {
+        const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+        complete(cqe.user_data, cqe.res);
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+  }
+
+ private:
+  /// Operation tags
+  static constexpr uint64_t rx_tag = 1;
+  static constexpr uint64_t wake_tag = 2;
+  static constexpr uint64_t tx_tag = 3;
+  static constexpr uint64_t cancel_tag = 4;
+
+  /**
+   * @brief Create the ring, map it, and register the read and write buffers
+   */
+  void setup()
+  {
+    io_uring_params params = {};
+    ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, 16, &params));
+    if (ring_fd_ == -1)
+    {
+      throw std::runtime_error(std::string("Failed to set up io_uring: ") + strerror(errno));
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ptr_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    cq_ptr_ = (params.features & IORING_FEAT_SINGLE_MMAP)
+                  ? sq_ptr_
+                  : ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                           IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(
+        ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+    if (sq_ptr_ == MAP_FAILED || cq_ptr_ == MAP_FAILED || sqes_ == MAP_FAILED)
+    {
+      throw std::runtime_error(std::string("Failed to map io_uring: ") + strerror(errno));
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    uint8_t* cq = static_cast<uint8_t*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Register the buffers (pinned once, instead of at each operation), index 0 for reads and 1 for writes
+    iovec iov[2] = {{rx_buffer_.data(), rx_buffer_.size()}, {tx_buffer_.data(), tx_buffer_.size()}};
+    if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iov, 2) != 0)
+    {
+      throw std::runtime_error(std::string("Failed to register io_uring buffers: ") + strerror(errno));
+    }
+  }
+
+  /**
+   * @brief Unmap and close the ring, as far as it was set up
+   */
+  void release()
+  {
+    if (sqes_ != nullptr && sqes_ != MAP_FAILED)
+    {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != nullptr && cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_)
+    {
+      ::munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != nullptr && sq_ptr_ != MAP_FAILED)
+    {
+      ::munmap(sq_ptr_, sq_size_);
+    }
+    if (ring_fd_ != -1)
+    {
+      ::close(ring_fd_);
+    }
+  }
+
+  /**
+   * @brief Queue an operation, submitted with the next io_uring_enter
+   * @param opcode (uint8_t)
+   * @param fd (int)
+   * @param buffer (pointer to void)
+   * @param size (uint32_t)
+   * @param buf_index index of the registered buffer, for fixed operations (uint16_t)
+   * @param tag (uint64_t)
+   */
+  void post(uint8_t opcode, int fd, void* buffer, uint32_t size, uint16_t buf_index, uint64_t tag)
+  {
+    // Never more than four operations in flight, the ring can not be full
+    const unsigned tail = *sq_tail_;
+    const unsigned idx = tail & *sq_mask_;
+    io_uring_sqe& sqe = sqes_[idx];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.off = static_cast<uint64_t>(-1);
+    sqe.addr = reinterpret_cast<uint64_t>(buffer);
+    sqe.len = size;
+    sqe.buf_index = buf_index;
+    sqe.user_data = tag;
+    sq_array_[idx] = idx;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++to_submit_;
+    if (tag != cancel_tag)
+    {
+      ++in_flight_;
+    }
+  }
+
+  /**
+   * @brief Queue the cancellation of an operation
+   * @param tag (uint64_t)
+   */
+  void cancel(uint64_t tag)
+  {
+    const unsigned tail = *sq_tail_;
+    post(IORING_OP_ASYNC_CANCEL, -1, nullptr, 0, 0, cancel_tag);
+    sqes_[tail & *sq_mask_].addr = tag;
+  }
+
+  /**
+   * @brief Post a read of the free space of the receive ring, if no read is in flight. None while the ring is full,
+   * until the transport reads and wakes the loop up
+   */
+  void startRead()
+  {
+    if (rx_in_flight_ || !active_)
+    {
+      return;
+    }
+    const size_t size = std::min(space(), rx_buffer_.size());
+    if (size > 0)
+    {
+      post(IORING_OP_READ_FIXED, fd_, rx_buffer_.data(), static_cast<uint32_t>(size), 0, rx_tag);
+      rx_in_flight_ = true;
+    }
+  }
+
+  /**
+   * @brief Start writing the queued bytes, if no write is in flight
+   */
+  void startWrite()
+  {
+    if (tx_in_flight_ || !active_)
+    {
+      return;
+    }
+    tx_offset_ = 0;
+    tx_size_ = take(tx_buffer_.data(), tx_buffer_.size());
+    if (tx_size_ > 0)
+    {
+      post(IORING_OP_WRITE_FIXED, fd_, tx_buffer_.data(), static_cast<uint32_t>(tx_size_), 1, tx_tag);
+      tx_in_flight_ = true;
+    }
+  }
+
+  /**
+   * @brief Handle a completion
+   * @param tag (uint64_t)
+   * @param res (int32_t)
+   */
+  void complete(uint64_t tag, int32_t res)
+  {
+    if (tag == cancel_tag)
+    {
+      return;
+    }
+    --in_flight_;
+
+    const bool retry = res == -EAGAIN || res == -EINTR;
+    switch (tag)
+    {
+      case rx_tag:
+        rx_in_flight_ = false;
+        if (res > 0)
+        {
+          push(rx_buffer_.data(), static_cast<size_t>(res));
+        }
+        else if (!retry && active_)
+        {
+          open_ = false;
+          return;
+        }
+        startRead();
+        break;
+
+      case wake_tag:
+        if (active_)
+        {
+          post(IORING_OP_READ, efd_, &wake_value_, sizeof(wake_value_), 0, wake_tag);
+          startRead();
+          startWrite();
+        }
+        break;
+
+      case tx_tag:
+        tx_in_flight_ = false;
+        if (res < 0 && !retry)
+        {
+          if (active_)
+          {
+            open_ = false;
+          }
+          return;
+        }
+        tx_offset_ += static_cast<size_t>(std::max(res, 0));
+        if (tx_offset_ < tx_size_ && active_)
+        {
+          post(IORING_OP_WRITE_FIXED, fd_, tx_buffer_.data() + tx_offset_,
+               static_cast<uint32_t>(tx_size_ - tx_offset_), 1, tx_tag);
+          tx_in_flight_ = true;
+        }
+        else
+        {
+          startWrite();
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  /// Ring file descriptor and mappings
+  int ring_fd_ = -1;
+  void* sq_ptr_ = nullptr;
+  void* cq_ptr_ = nullptr;
+  size_t sq_size_ = 0;
+  size_t cq_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+
+  /// Operations queued but not submitted, and operations in flight
+  unsigned to_submit_ = 0;
+  unsigned in_flight_ = 0;
+  bool cancelled_ = false;
+
+  /// Registered read and write buffers
+  Bytes rx_buffer_;
+  bool rx_in_flight_ = false;
+  Bytes tx_buffer_;
+  size_t tx_offset_ = 0;
+  size_t tx_size_ = 0;
+  bool tx_in_flight_ = false;
+
+  /// Wake up event value
+  uint64_t wake_value_ = 0;
+};
+
+AsyncSerialTransport::AsyncSerialTransport(const std::string& port, const uint32_t& baudrate, const IoBackend& backend)
+    : serial_(std::make_unique<serial::Serial>(port, baudrate, serial::Timeout::simpleTimeout(0))), port_(port)
+{
+  if (backend == IoBackend::IO_URING || (backend == IoBackend::AUTO && uringAvailable()))
+  {
+    try
+    {
+      // Blocking reads returning as soon as one byte is received
+      serial_->setLowLatency(1, 0);
+      loop_ = std::make_unique<UringLoop>(serial_->getFd());
+    }
+    catch (const std::exception&)
+    {
+      // e.g. the buffers can not be registered under RLIMIT_MEMLOCK, back to non-blocking reads for epoll
+      if (backend == IoBackend::IO_URING)
+      {
+        throw;
+      }
+      serial_->setLowLatency(0, 0);
+    }
+  }
+  if (!loop_)
+  {
+    loop_ = std::make_unique<EpollLoop>(serial_->getFd());
+  }
+}
+
+AsyncSerialTransport::AsyncSerialTransport(int fd, const IoBackend& backend) : port_("fd:" + std::to_string(fd))
+{
+  if (backend == IoBackend::IO_URING || (backend == IoBackend::AUTO && uringAvailable()))
+  {
+    try
+    {
+      loop_ = std::make_unique<UringLoop>(fd);
+    }
+    catch (const std::exception&)
+    {
+      if (backend == IoBackend::IO_URING)
+      {
+        throw;
+      }
+    }
+  }
+  if (!loop_)
+  {
+    loop_ = std::make_unique<EpollLoop>(fd);
+  }
+}
+
+AsyncSerialTransport::~AsyncSerialTransport()
+{
+  // Stop the loop before closing the port
+  loop_.reset();
+  if (serial_)
+  {
+    serial_->close();
+  }
+}
+
+bool AsyncSerialTransport::isOpen() const
+{
+  return loop_->open_;
+}
+
+void AsyncSerialTransport::close()
+{
+  loop_->open_ = false;
+}
+
+size_t AsyncSerialTransport::available()
+{
+  return loop_->available();
+}
+
+size_t AsyncSerialTransport::read(uint8_t* buffer, size_t size)
+{
+  return loop_->read(buffer, size);
+}
+
+size_t AsyncSerialTransport::write(const ConstBuffer* buffers, size_t count)
+{
+  return loop_->write(buffers, count);
+}
+
+IoBackend AsyncSerialTransport::getBackend() const
+{
+  return loop_->backend();
+}
+
+uint64_t AsyncSerialTransport::getSyscalls() const
+{
+  return loop_->syscalls_;
+}
+
+uint64_t AsyncSerialTransport::getFrames() const
+{
+  return loop_->frames_;
+}
+
+bool AsyncSerialTransport::uringAvailable()
+{
+  return UringLoop::available();
+}
+}  // namespace mspfci
\ No newline at end of file
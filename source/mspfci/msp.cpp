@@ -1,38 +1,64 @@
 #include "mspfci/msp.hpp"
 
+#include <thread>
+
 namespace mspfci
 {
 MSP::MSP(std::shared_ptr<Logger> logger, const std::string& port, const uint32_t& baudrate, const MSPVer& ver)
-    : serial_(std::make_unique<serial::Serial>(port, baudrate, serial::Timeout::simpleTimeout(0)))
-    , logger_(std::move(logger))
+    : MSP(std::move(logger), std::make_unique<SerialTransport>(port, baudrate), ver)
+{
+}
+
+MSP::MSP(std::shared_ptr<Logger> logger, std::unique_ptr<Transport> transport, const MSPVer& ver)
+    : transport_(std::move(transport)), logger_(std::move(logger))
 {
-  logger_->info("MSP: Connection established on port " + port);
-  logger_->info("MSP: Baudrate set to " + std::to_string(baudrate));
+  logger_->info("MSP: Connection established on port " + transport_->getPort());
+  logger_->info("MSP: Baudrate set to " + std::to_string(transport_->getBaudrate()));
+  if (transport_->getEffectiveBaudrate() != transport_->getBaudrate())
+  {
+    logger_->warn("MSP: Effective baudrate is " + std::to_string(transport_->getEffectiveBaudrate()));
+  }
   setMspVersion(ver);
 }
 
 bool MSP::send(const MSPCode& code, const Bytes& data)
 {
-  // Check serial connection
-  if (!serial_->isOpen())
+  // Codes from 256 on only exist in MSPv2
+  return write(code, data, '<', static_cast<uint16_t>(code) > 0xFF ? MSPVer::MSPv2 : msp_version_);
+}
+
+bool MSP::respond(const MSPCode& code, const Bytes& data, const bool& error)
+{
+  return write(code, data, error ? '!' : '>', received_version_);
+}
+
+bool MSP::write(const MSPCode& code, const Bytes& data, const uint8_t& direction, const MSPVer& version)
+{
+  // Check connection
+  if (!transport_->isOpen())
   {
     logger_->err("MSP::send: Serial port is close");
     return false;
   }
 
-  // check data size to net exceed the max payload size
-  if (data.size() >= max_payload_bytes_)
+  // check data size to net exceed the max payload size (MSPv1 jumbo frames carry up to 65535 bytes as well)
+  if (data.size() > max_payload_bytes)
   {
     logger_->err("MSP::send: Data size bigger than maximum payload");
     return false;
   }
 
-  // Send command
-  Bytes msg = pack(code, data);
-  size_t bytes_written = serial_->write(msg);
+  // Pack header and crc, the payload is written in place
+  std::array<uint8_t, Parser::max_header_size> header;
+  const size_t header_size = Parser::packHeader(version, code, data.size(), direction, header.data());
+  const uint8_t checksum = Parser::checksum(version, header.data(), header_size, data.data(), data.size());
+
+  // Send command, with a single scatter-gather write
+  const ConstBuffer buffers[] = {{header.data(), header_size}, {data.data(), data.size()}, {&checksum, 1}};
+  size_t bytes_written = transport_->write(buffers, 3);
 
   // Check that all the bytes were written
-  if (bytes_written != msg.size())
+  if (bytes_written != header_size + data.size() + 1)
   {
     logger_->err("MSP::send: Write failed");
     return false;
@@ -42,246 +68,87 @@ bool MSP::send(const MSPCode& code, const Bytes& data)
   return true;
 }
 
-// https://github.com/iNavFlight/inav/wiki/MSP-V2
-// http://www.multiwii.com/wiki/index.php?title=Multiwii_Serial_Protocol
-const Bytes MSP::pack(const MSPCode& code, const Bytes& data)
-{
-  Bytes msg;
-  if (msp_version_ == MSPVer::MSPv1)
-  {
-    // Preamble
-    msg.push_back('$');
-    msg.push_back('M');
-
-    // Direction
-    msg.push_back('<');
-
-    // Size
-    msg.push_back(static_cast<uint8_t>(data.size()));
-
-    // Command code
-    msg.push_back(static_cast<uint8_t>(code));
-
-    // Data
-    msg.insert(msg.end(), data.begin(), data.end());
-
-    // CRC
-    msg.push_back(crc(code, data));
-  }
-  else
-  {
-    // Preamble
-    msg.push_back('$');
-    msg.push_back('X');
-
-    // Direction
-    msg.push_back('<');
-
-    // Flag
-    msg.push_back(0);
-
-    // Split command code in two bytes
-    const uint16_t cmd_code = static_cast<uint16_t>(code);
-    msg.push_back(static_cast<uint8_t>(cmd_code & 0x00FF));
-    msg.push_back(static_cast<uint8_t>(cmd_code >> 8));
-
-    // Split data size intwo two bytes
-    const uint16_t data_size = static_cast<uint16_t>(data.size());
-    msg.push_back(static_cast<uint8_t>(data_size & 0xFF));
-    msg.push_back(static_cast<uint8_t>(data_size >> 8));
-
-    // Data
-    msg.insert(msg.end(), data.begin(), data.end());
-
-    // CRC
-    msg.push_back(crc(code, Bytes(msg.begin() + 3, msg.end())));
-  }
-  return msg;
-}
-
-// https://github.com/iNavFlight/inav/wiki/MSP-V2
-uint8_t MSP::crc(const MSPCode& code, const Bytes& data)
+bool MSP::receive(Bytes& data)
 {
-  uint8_t crc;
-  if (msp_version_ == MSPVer::MSPv1)
-  {
-    crc = static_cast<uint8_t>(data.size()) ^ static_cast<uint8_t>(code);
-    for (const auto& it : data)
-    {
-      crc ^= it;
-    }
-  }
-  else
-  {
-    crc = 0;
-    for (const auto& it : data)
-    {
-      crc ^= it;
-      for (int i = 0; i < 8; ++i)
-      {
-        if (crc & 0x80)
-        {
-          crc = uint8_t(crc << 1) ^ 0xD5;
-        }
-        else
-        {
-          crc = uint8_t(crc << 1);
-        }
-      }
-    }
-  }
-  return crc;
+  MSPCode code;
+  return receive(code, data);
 }
 
-bool MSP::receive(Bytes& data)
+bool MSP::receive(MSPCode& code, Bytes& data)
 {
-  // Check serial connection
-  if (!serial_->isOpen())
+  // Check connection
+  if (!transport_->isOpen())
   {
     logger_->err("MSP::receive: Serial port is close");
     return false;
   }
 
-  // Define buffer (LIFO)
-  Bytes read_buffer;
-
-  // Read until magic charater is found
-  while (true)
-  {
-    // Read one byte as soon as there is a byte in the buffer
-    serial_->read(read_buffer, 1);
-
-    // Check if magic character has been found otherwise clear the buffer
-    if (!read_buffer.empty() && read_buffer.back() == '$')
-    {
-      break;
-    }
-    else
-    {
-      read_buffer.clear();
-    }
-  }
-
-  return unpack(read_buffer, data);
+  // Set the deadline of the receive
+  deadline_ = std::chrono::steady_clock::now() + timeout_;
+  return receiveFrame(code, data);
 }
 
-bool MSP::unpack(Bytes& read_buffer, Bytes& data)
+bool MSP::tryReceive(MSPCode& code, Bytes& data)
 {
-  // Wait until one byte is available and read it
-  while (serial_->available() < 1)
+  if (!transport_->isOpen())
   {
+    return false;
   }
-  serial_->read(read_buffer, 1);
 
-  // define type, data_size and code
-  uint8_t type;
-  size_t data_size;
-  MSPCode code;
+  // Deadline already met, only the bytes already received are parsed
+  deadline_ = std::chrono::steady_clock::time_point::min();
+  return receiveFrame(code, data);
+}
 
-  // Check the second character to define the version of the message
-  if (read_buffer.back() == 'M')
+bool MSP::receiveFrame(MSPCode& code, Bytes& data)
+{
+  // Parse the bytes left by the previous receive, then the received ones as they arrive. Each frame is decoded
+  // according to its own header, whatever the version in use for sending
+  while (true)
   {
-    if (msp_version_ != MSPVer::MSPv1)
+    if (rx_offset_ < rx_buffer_.size())
     {
-      logger_->warn(
-          "MSP::receive: Received message with MSPv2 protocol. "
-          "Dropping this message and switching from MSPv1 to MSPv2");
-      setMspVersion(MSPVer::MSPv2);
-      read_buffer.clear();
-      return false;
+      rx_offset_ += parser_.parse(rx_buffer_.data() + rx_offset_, rx_buffer_.size() - rx_offset_);
+      if (parser_.ready())
+      {
+        const Frame& frame = parser_.frame();
+        code = frame.code;
+        received_version_ = frame.version;
+        if (frame.direction == '!')
+        {
+          logger_->err("MSP::receive: Received message with error type (!)");
+          return false;
+        }
+        data.insert(data.end(), frame.payload.begin(), frame.payload.end());
+        return true;
+      }
+      continue;
     }
 
-    // Wait until three bytes are available and read them
-    while (serial_->available() < 3)
-    {
-    }
-    if (serial_->read(read_buffer, 3) != 3)
+    // Read all the available bytes, allowing their transmission time
+    if (!waitAvailable(1))
     {
       return false;
     }
-
-    // Get the msp code, data size and the type from the buffer
-    // Note that x.rbegin()[n] = *(x.rbegin() + n) = *(x.end() - (n+1))
-    code = static_cast<MSPCode>(read_buffer.back());
-    data_size = static_cast<size_t>(read_buffer.rbegin()[1]);
-    type = read_buffer.rbegin()[2];
+    rx_buffer_.clear();
+    rx_offset_ = 0;
+    const size_t size = transport_->read(rx_buffer_, transport_->available());
+    deadline_ += getByteTime() * size;
   }
-  else if (read_buffer.back() == 'X')
-  {
-    if (msp_version_ != MSPVer::MSPv2)
-    {
-      logger_->warn(
-          "MSP::receive: Received message with MSPv2 protocol. "
-          "Dropping this message and switching from MSPv1 to MSPv2");
-      setMspVersion(MSPVer::MSPv1);
-      read_buffer.clear();
-      return false;
-    }
+}
 
-    // Wait until six bytes are available and read them
-    while (serial_->available() < 6)
-    {
-    }
-    if (serial_->read(read_buffer, 6) != 6)
+bool MSP::waitAvailable(size_t size)
+{
+  // Busy wait, as long as the connection is open and the deadline is not met, yielding to let the other end run
+  const auto start = std::chrono::steady_clock::now();
+  while (transport_->available() < size)
+  {
+    if (!transport_->isOpen() || std::chrono::steady_clock::now() > deadline_)
     {
       return false;
     }
-
-    // Get the data size, msp code and the type from the buffer
-    // Note that x.rbegin()[n] = *(x.rbegin() + n) = *(x.end()-1 - n))
-    data_size = static_cast<size_t>(static_cast<uint16_t>(read_buffer.back() << 8) |
-                                    static_cast<uint16_t>(read_buffer.rbegin()[1]));
-    code = static_cast<MSPCode>(static_cast<uint16_t>(read_buffer.rbegin()[2] << 8) |
-                                static_cast<uint16_t>(read_buffer.rbegin()[3]));
-    type = read_buffer.rbegin()[5];
+    backoff(start);
   }
-  else
-  {
-    return false;
-  }
-
-  // Check type
-  if (type == '!')
-  {
-    logger_->err("MSP::receive: Received message with error type (!)");
-    return false;
-  }
-
-  // Read data_size bytes and fill data buffer
-  while (serial_->available() < data_size)
-  {
-  }
-  if (serial_->read(data, data_size) != data_size)
-  {
-    return false;
-  }
-
-  // Set checksummable
-  Bytes checksummable;
-  if (msp_version_ == MSPVer::MSPv1)
-  {
-    checksummable = data;
-  }
-  else
-  {
-    checksummable = read_buffer;
-    checksummable.erase(checksummable.begin(), checksummable.begin() + 3);
-    checksummable.insert(checksummable.end(), data.begin(), data.end());
-  }
-
-  // Read last byte (crc)
-  while (serial_->available() < 1)
-  {
-  }
-  serial_->read(read_buffer, 1);
-
-  // Check CRC and return
-  if (read_buffer.back() != crc(code, checksummable))
-  {
-    logger_->err("MSP::receive: Checksum failed");
-    return false;
-  }
-
   return true;
 }
 }  // namespace mspfci
\ No newline at end of file
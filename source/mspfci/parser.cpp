@@ -0,0 +1,250 @@
+#include "mspfci/parser.hpp"
+
+#include <algorithm>
+
+namespace mspfci
+{
+size_t Parser::parse(const uint8_t* data, size_t size)
+{
+  ready_ = false;
+  size_t i = 0;
+  while (i < size && !ready_)
+  {
+    // Copy as much of the payload as available at once
+    if (state_ == State::PAYLOAD)
+    {
+      const size_t count = std::min(size - i, size_ - frame_.payload.size());
+      frame_.payload.insert(frame_.payload.end(), data + i, data + i + count);
+      i += count;
+      if (frame_.payload.size() == size_)
+      {
+        state_ = State::CHECKSUM;
+      }
+      continue;
+    }
+
+    const uint8_t byte = data[i++];
+    switch (state_)
+    {
+      case State::IDLE:
+        // Skip until the magic character
+        state_ = byte == '$' ? State::PROTOCOL : State::IDLE;
+        break;
+
+      case State::PROTOCOL:
+        if (byte == 'M' || byte == 'X')
+        {
+          frame_.version = byte == 'M' ? MSPVer::MSPv1 : MSPVer::MSPv2;
+          state_ = State::DIRECTION;
+        }
+        else
+        {
+          state_ = byte == '$' ? State::PROTOCOL : State::IDLE;
+        }
+        break;
+
+      case State::DIRECTION:
+        if (byte == '<' || byte == '>' || byte == '!')
+        {
+          frame_.direction = byte;
+          state_ = frame_.version == MSPVer::MSPv1 ? State::V1_SIZE : State::V2_FLAG;
+        }
+        else
+        {
+          state_ = byte == '$' ? State::PROTOCOL : State::IDLE;
+        }
+        break;
+
+      case State::V1_SIZE:
+        size_ = byte;
+        crc_ = byte;
+        state_ = State::V1_CODE;
+        break;
+
+      case State::V1_CODE:
+        code_ = byte;
+        crc_ ^= byte;
+        // Jumbo frame, the size byte is followed by the actual 16-bit size
+        state_ = size_ == jumbo_size ? State::V1_JUMBO_SIZE_LOW : State::PAYLOAD;
+        break;
+
+      case State::V1_JUMBO_SIZE_LOW:
+        size_ = byte;
+        crc_ ^= byte;
+        state_ = State::V1_JUMBO_SIZE_HIGH;
+        break;
+
+      case State::V1_JUMBO_SIZE_HIGH:
+        size_ |= static_cast<size_t>(byte) << 8;
+        crc_ ^= byte;
+        state_ = State::PAYLOAD;
+        break;
+
+      case State::V2_FLAG:
+        crc_ = crc8(0, &byte, 1);
+        state_ = State::V2_CODE_LOW;
+        break;
+
+      case State::V2_CODE_LOW:
+        code_ = byte;
+        crc_ = crc8(crc_, &byte, 1);
+        state_ = State::V2_CODE_HIGH;
+        break;
+
+      case State::V2_CODE_HIGH:
+        code_ |= static_cast<uint16_t>(byte << 8);
+        crc_ = crc8(crc_, &byte, 1);
+        state_ = State::V2_SIZE_LOW;
+        break;
+
+      case State::V2_SIZE_LOW:
+        size_ = byte;
+        crc_ = crc8(crc_, &byte, 1);
+        state_ = State::V2_SIZE_HIGH;
+        break;
+
+      case State::V2_SIZE_HIGH:
+        size_ |= static_cast<size_t>(byte) << 8;
+        crc_ = crc8(crc_, &byte, 1);
+        state_ = State::PAYLOAD;
+        break;
+
+      case State::CHECKSUM:
+      {
+        // Checksum of the payload
+        uint8_t crc = crc_;
+        if (frame_.version == MSPVer::MSPv1)
+        {
+          for (const auto& it : frame_.payload)
+          {
+            crc ^= it;
+          }
+        }
+        else
+        {
+          crc = crc8(crc, frame_.payload.data(), frame_.payload.size());
+        }
+
+        if (crc == byte)
+        {
+          ready_ = true;
+        }
+        else
+        {
+          ++crc_errors_;
+        }
+        state_ = State::IDLE;
+        break;
+      }
+
+      case State::PAYLOAD:
+        break;
+    }
+
+    // Header complete, start receiving the payload
+    if (state_ == State::PAYLOAD)
+    {
+      frame_.code = static_cast<MSPCode>(code_);
+      frame_.payload.clear();
+      state_ = size_ == 0 ? State::CHECKSUM : State::PAYLOAD;
+    }
+  }
+  return i;
+}
+
+// https://github.com/iNavFlight/inav/wiki/MSP-V2
+// http://www.multiwii.com/wiki/index.php?title=Multiwii_Serial_Protocol
+size_t Parser::packHeader(const MSPVer& version, const MSPCode& code, size_t size, uint8_t direction, uint8_t* header)
+{
+  // Preamble
+  header[0] = '$';
+  header[1] = (version == MSPVer::MSPv1) ? 'M' : 'X';
+
+  // Direction
+  header[2] = direction;
+
+  if (version == MSPVer::MSPv1)
+  {
+    // Size, or jumbo frame from 255 bytes on
+    const bool jumbo = size >= jumbo_size;
+    header[3] = jumbo ? jumbo_size : static_cast<uint8_t>(size);
+
+    // Command code
+    header[4] = static_cast<uint8_t>(code);
+    if (!jumbo)
+    {
+      return 5;
+    }
+
+    // Split data size into two bytes
+    header[5] = static_cast<uint8_t>(size & 0xFF);
+    header[6] = static_cast<uint8_t>(size >> 8);
+    return 7;
+  }
+
+  // Flag
+  header[3] = 0;
+
+  // Split command code in two bytes
+  const uint16_t cmd_code = static_cast<uint16_t>(code);
+  header[4] = static_cast<uint8_t>(cmd_code & 0x00FF);
+  header[5] = static_cast<uint8_t>(cmd_code >> 8);
+
+  // Split data size intwo two bytes
+  const uint16_t data_size = static_cast<uint16_t>(size);
+  header[6] = static_cast<uint8_t>(data_size & 0xFF);
+  header[7] = static_cast<uint8_t>(data_size >> 8);
+
+  return 8;
+}
+
+void Parser::pack(
+    const MSPVer& version, const MSPCode& code, const uint8_t* data, size_t size, uint8_t direction, Bytes& frame)
+{
+  uint8_t header[max_header_size];
+  const size_t header_size = packHeader(version, code, size, direction, header);
+  frame.insert(frame.end(), header, header + header_size);
+  frame.insert(frame.end(), data, data + size);
+  frame.push_back(checksum(version, header, header_size, data, size));
+}
+
+// http://www.multiwii.com/wiki/index.php?title=Multiwii_Serial_Protocol
+uint8_t Parser::checksum(
+    const MSPVer& version, const uint8_t* header, size_t header_size, const uint8_t* data, size_t size)
+{
+  if (version == MSPVer::MSPv2)
+  {
+    return crc8(crc8(0, header + 3, header_size - 3), data, size);
+  }
+  uint8_t crc = 0;
+  for (size_t i = 3; i < header_size; ++i)
+  {
+    crc ^= header[i];
+  }
+  for (size_t i = 0; i < size; ++i)
+  {
+    crc ^= data[i];
+  }
+  return crc;
+}
+
+uint8_t Parser::crc8(uint8_t crc, const uint8_t* data, size_t size)
+{
+  for (size_t j = 0; j < size; ++j)
+  {
+    crc ^= data[j];
+    for (int i = 0; i < 8; ++i)
+    {
+      if (crc & 0x80)
+      {
+        crc = uint8_t(crc << 1) ^ 0xD5;
+      }
+      else
+      {
+        crc = uint8_t(crc << 1);
+      }
+    }
+  }
+  return crc;
+}
+}  // namespace mspfci
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "mspfci/periodic_callback.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mspfci
+{
+PeriodicCallback::PeriodicCallback(std::shared_ptr<Logger> logger,
+                                   std::shared_ptr<Engine> engine,
+                                   std::unique_ptr<Msg> msg)
+    : logger_(std::move(logger)), engine_(std::move(engine)), msg_(std::move(msg))
+{
+  th_ = std::thread([this]() { run(); });
+}
+
+PeriodicCallback::~PeriodicCallback()
+{
+  // Deactivate
+  {
+    std::scoped_lock lock(mtx_);
+    active_ = false;
+  }
+  cv_.notify_one();
+
+  // Check if thread joinable, then wait for it to complete its execution (join)
+  if (th_.joinable())
+  {
+    th_.join();
+  }
+}
+
+void PeriodicCallback::add(const size_t& id, std::unique_ptr<Subscriber> subscriber, float freq)
+{
+  {
+    std::scoped_lock lock(mtx_);
+    subscriber->period_ = toPeriod(freq);
+    subscribers_.emplace(id, std::move(subscriber));
+    reschedule();
+  }
+  cv_.notify_one();
+}
+
+bool PeriodicCallback::remove(const size_t& id)
+{
+  bool empty;
+  {
+    std::scoped_lock lock(delivery_mtx_, mtx_);
+    subscribers_.erase(id);
+    reschedule();
+    empty = subscribers_.empty();
+  }
+  cv_.notify_one();
+  return empty;
+}
+
+void PeriodicCallback::pause(const size_t& id)
+{
+  {
+    std::scoped_lock lock(mtx_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end())
+    {
+      return;
+    }
+    it->second->paused_ = true;
+    reschedule();
+  }
+  cv_.notify_one();
+}
+
+void PeriodicCallback::resume(const size_t& id)
+{
+  {
+    std::scoped_lock lock(mtx_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end())
+    {
+      return;
+    }
+    it->second->paused_ = false;
+    it->second->due_ = std::chrono::steady_clock::time_point::min();
+    reschedule();
+  }
+  cv_.notify_one();
+}
+
+void PeriodicCallback::setFrequency(const size_t& id, float freq)
+{
+  {
+    std::scoped_lock lock(mtx_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end())
+    {
+      return;
+    }
+    it->second->adaptive_.reset();
+    it->second->period_ = toPeriod(freq);
+    reschedule();
+  }
+  cv_.notify_one();
+}
+
+void PeriodicCallback::setAdaptive(const size_t& id, float min_freq, float max_freq)
+{
+  {
+    std::scoped_lock lock(mtx_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end())
+    {
+      return;
+    }
+    it->second->adaptive_.emplace(min_freq, max_freq);
+    it->second->period_ = toPeriod(it->second->adaptive_->second);
+    reschedule();
+  }
+  cv_.notify_one();
+}
+
+float PeriodicCallback::getFrequency(const size_t& id)
+{
+  std::scoped_lock lock(mtx_);
+  auto it = subscribers_.find(id);
+  if (it == subscribers_.end() || period_ == std::chrono::nanoseconds::zero())
+  {
+    return 0.0f;
+  }
+
+  // Decimated to the period of the subscriber
+  const std::chrono::nanoseconds period = std::max(period_, it->second->period_);
+  return static_cast<float>(std::nano::den) / static_cast<float>(period.count());
+}
+
+RateStats PeriodicCallback::getRateStats()
+{
+  std::scoped_lock lock(mtx_);
+  return rate_ ? rate_->getStats() : RateStats();
+}
+
+LatencyStats PeriodicCallback::getJitter()
+{
+  std::scoped_lock lock(mtx_);
+  return jitter_;
+}
+
+bool PeriodicCallback::isValidFrequency(float freq)
+{
+  return std::isfinite(freq) && freq > 0 &&
+         std::nano::den / freq < static_cast<float>(std::numeric_limits<std::chrono::nanoseconds::rep>::max());
+}
+
+std::chrono::nanoseconds PeriodicCallback::toPeriod(float freq)
+{
+  return std::chrono::nanoseconds(std::chrono::nanoseconds::rep(std::nano::den / freq));
+}
+
+void PeriodicCallback::reschedule()
+{
+  // Fastest fixed period, and frequency range of the adaptive subscribers, among the running ones
+  std::chrono::nanoseconds fixed = std::chrono::nanoseconds::max();
+  std::optional<std::pair<float, float>> adaptive;
+  for (const auto& [id, subscriber] : subscribers_)
+  {
+    if (subscriber->paused_)
+    {
+      continue;
+    }
+    if (subscriber->adaptive_)
+    {
+      adaptive = adaptive ? std::make_pair(std::max(adaptive->first, subscriber->adaptive_->first),
+                                           std::max(adaptive->second, subscriber->adaptive_->second))
+                          : *subscriber->adaptive_;
+    }
+    else
+    {
+      fixed = std::min(fixed, subscriber->period_);
+    }
+  }
+
+  paused_ = !adaptive && fixed == std::chrono::nanoseconds::max();
+  if (paused_)
+  {
+    return;
+  }
+
+  // The adaptive range is raised to the fastest fixed frequency, the controller restarting if the range changes
+  if (adaptive)
+  {
+    if (fixed != std::chrono::nanoseconds::max())
+    {
+      const float freq = static_cast<float>(std::nano::den) / static_cast<float>(fixed.count());
+      adaptive->first = std::max(adaptive->first, freq);
+      adaptive->second = std::max(adaptive->second, adaptive->first);
+    }
+    if (!rate_ || rate_range_ != *adaptive)
+    {
+      rate_.emplace(adaptive->first, adaptive->second);
+      rate_range_ = *adaptive;
+    }
+    period_ = toPeriod(rate_->getFrequency());
+  }
+  else
+  {
+    rate_.reset();
+    period_ = fixed;
+  }
+}
+
+void PeriodicCallback::run()
+{
+  // Schedule of the next request, none until the first one
+  auto deadline = std::chrono::steady_clock::time_point::min();
+
+  // Loop while active
+  while (active_)
+  {
+    // Wait while paused, the schedule restarts once resumed
+    {
+      std::unique_lock lock(mtx_);
+      if (paused_)
+      {
+        cv_.wait(lock, [this]() { return !active_ || !paused_; });
+        deadline = std::chrono::steady_clock::time_point::min();
+        if (!active_)
+        {
+          break;
+        }
+      }
+    }
+
+    // Start time, and lateness with respect to the schedule
+    const auto start_time = std::chrono::steady_clock::now();
+    if (deadline != std::chrono::steady_clock::time_point::min())
+    {
+      std::scoped_lock lock(mtx_);
+      jitter_.add(std::max(start_time - deadline, std::chrono::nanoseconds::zero()));
+    }
+
+    // Clear raw data
+    raw_data.clear();
+
+    // Send data request through the engine, as telemetry, and wait for the response. A failed request waits for the
+    // next period as well, e.g. while the port is reconnecting
+    const bool succeeded = engine_->request(msg_->getCode(), mspfci::Bytes(), raw_data, Priority::TELEMETRY);
+    ++requests_;
+    if (!succeeded)
+    {
+      logger_->err("Failed to receive data");
+    }
+
+    // Adapt the frequency to the outcome of the request, and take the subscribers due, within half a period
+    std::unique_lock delivery_lock(delivery_mtx_);
+    {
+      std::scoped_lock lock(mtx_);
+      if (rate_)
+      {
+        period_ = toPeriod(
+            rate_->update(succeeded, std::chrono::steady_clock::now() - start_time, engine_->getCrcErrors()));
+      }
+      due_.clear();
+      const auto tolerance = period_ / 2;
+      for (auto& [id, subscriber] : subscribers_)
+      {
+        if (!subscriber->paused_ && start_time + tolerance >= subscriber->due_)
+        {
+          due_.push_back(subscriber.get());
+        }
+      }
+    }
+
+    // Decode once, and deliver to the subscribers due
+    bool delivered = false;
+    if (succeeded && !due_.empty())
+    {
+      if (!msg_->decodeMessage(raw_data))
+      {
+        logger_->err("Failed to decode data");
+      }
+      else
+      {
+        ++decoded_;
+        for (Subscriber* subscriber : due_)
+        {
+          subscriber->deliver(*msg_);
+        }
+        delivered = true;
+      }
+    }
+
+    // Only once delivered, schedule the next delivery: one period later, or one period from now if late by more than a
+    // period. After a failed request or decoding, the subscribers stay due for the next request
+    if (delivered)
+    {
+      std::scoped_lock lock(mtx_);
+      for (Subscriber* subscriber : due_)
+      {
+        subscriber->due_ += subscriber->period_;
+        if (subscriber->due_ < start_time)
+        {
+          subscriber->due_ = start_time + subscriber->period_;
+        }
+      }
+    }
+    delivery_lock.unlock();
+
+    // Wait for the next period, rescheduled if the frequency changes meanwhile, woken up on stop or pause
+    std::unique_lock lock(mtx_);
+    bool retuned = false;
+    while (active_ && !paused_)
+    {
+      const std::chrono::nanoseconds period = period_;
+      deadline = start_time + period;
+      if (std::chrono::steady_clock::now() > deadline)
+      {
+        if (!retuned && !rate_)
+        {
+          logger_->warn("Unable to meet frequency requirements");
+        }
+        break;
+      }
+      if (!cv_.wait_until(lock, deadline, [this, &period]() { return !active_ || paused_ || period_ != period; }))
+      {
+        break;
+      }
+      retuned = true;
+    }
+  }
+}
+}  // namespace mspfci
\ No newline at end of file
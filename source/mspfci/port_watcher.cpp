@@ -0,0 +1,262 @@
+#include "mspfci/port_watcher.hpp"
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <string_view>
+
+namespace mspfci
+{
+/// Device name prefixes of the serial ports, as scanned by serial::list_ports
+static constexpr std::array<std::string_view, 4> port_prefixes = {"ttyACM", "ttyUSB", "ttyS", "rfcomm"};
+
+PortWatcher::PortWatcher(std::shared_ptr<Logger> logger) : logger_(std::move(logger))
+{
+  // Subscribe to the kernel uevents before the scan, so that no event is missed in between
+  sock_ = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+  sockaddr_nl addr = {};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = 1;
+  if (sock_ == -1 || ::bind(sock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+  {
+    logger_->err(std::string("PortWatcher: Failed to listen to uevents, ports are not watched: ") + strerror(errno));
+  }
+
+  // Full scan, once
+  for (const auto& info : serial::list_ports())
+  {
+    ports_[info.port] = info;
+  }
+
+  efd_ = ::eventfd(0, EFD_CLOEXEC);
+  if (sock_ != -1 && efd_ != -1)
+  {
+    active_ = true;
+    th_ = std::thread([this]() { run(); });
+  }
+}
+
+PortWatcher::~PortWatcher()
+{
+  if (active_.exchange(false))
+  {
+    const uint64_t one = 1;
+    [[maybe_unused]] ssize_t n = ::write(efd_, &one, sizeof(one));
+  }
+  if (th_.joinable())
+  {
+    th_.join();
+  }
+  ::close(efd_);
+  ::close(sock_);
+}
+
+std::vector<serial::PortInfo> PortWatcher::getPorts()
+{
+  std::scoped_lock lock(ports_mtx_);
+  std::vector<serial::PortInfo> ports;
+  ports.reserve(ports_.size());
+  for (const auto& [port, info] : ports_)
+  {
+    ports.push_back(info);
+  }
+  return ports;
+}
+
+bool PortWatcher::isPresent(const std::string& port)
+{
+  std::scoped_lock lock(ports_mtx_);
+  return ports_.count(port) > 0;
+}
+
+size_t PortWatcher::addCallback(Callback callback)
+{
+  std::scoped_lock lock(callbacks_mtx_);
+  callbacks_.emplace(next_id_, std::move(callback));
+  return next_id_++;
+}
+
+void PortWatcher::removeCallback(const size_t& id)
+{
+  {
+    std::scoped_lock lock(callbacks_mtx_);
+    callbacks_.erase(id);
+  }
+
+  // Wait for the notification in progress, unless called from a callback
+  if (std::this_thread::get_id() != th_.get_id())
+  {
+    std::scoped_lock lock(notify_mtx_);
+  }
+}
+
+void PortWatcher::run()
+{
+  char buffer[8192];
+  pollfd fds[2] = {{sock_, POLLIN, 0}, {efd_, POLLIN, 0}};
+  while (active_)
+  {
+    if (::poll(fds, 2, -1) == -1)
+    {
+      // Back off on a persistent error, waking up on stop
+      if (errno != EINTR)
+      {
+        logger_->err(std::string("PortWatcher: Failed to wait for uevents: ") + strerror(errno));
+        ::poll(&fds[1], 1, 100);
+      }
+      continue;
+    }
+    if (fds[0].revents & POLLIN)
+    {
+      // Only trust the uevents sent by the kernel
+      sockaddr_nl sender = {};
+      socklen_t sender_size = sizeof(sender);
+      const ssize_t n = ::recvfrom(sock_, buffer, sizeof(buffer), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&sender),
+                                   &sender_size);
+      if (n > 0 && sender.nl_pid == 0)
+      {
+        handle(buffer, static_cast<size_t>(n));
+      }
+      else if (n == -1 && errno == ENOBUFS)
+      {
+        // The socket buffer overflowed, uevents have been lost and the device table may be stale
+        rescan();
+      }
+      else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      {
+        logger_->err(std::string("PortWatcher: Failed to receive uevents: ") + strerror(errno));
+      }
+    }
+  }
+}
+
+void PortWatcher::handle(const char* data, size_t size)
+{
+  // A uevent is a header ("action@devpath") followed by null-terminated KEY=value fields
+  std::string_view action, subsystem, devname;
+  size_t offset = strnlen(data, size) + 1;
+  while (offset < size)
+  {
+    const std::string_view field(data + offset, strnlen(data + offset, size - offset));
+    offset += field.size() + 1;
+    if (field.rfind("ACTION=", 0) == 0)
+    {
+      action = field.substr(7);
+    }
+    else if (field.rfind("SUBSYSTEM=", 0) == 0)
+    {
+      subsystem = field.substr(10);
+    }
+    else if (field.rfind("DEVNAME=", 0) == 0)
+    {
+      devname = field.substr(8);
+    }
+  }
+
+  // Filter the serial ports
+  if (subsystem != "tty" || (action != "add" && action != "remove"))
+  {
+    return;
+  }
+  bool serial_port = false;
+  for (const auto& prefix : port_prefixes)
+  {
+    serial_port |= devname.rfind(prefix, 0) == 0;
+  }
+  if (!serial_port)
+  {
+    return;
+  }
+
+  // Update the device table
+  const std::string port = "/dev/" + std::string(devname);
+  serial::PortInfo info;
+  PortEvent event;
+  {
+    std::scoped_lock lock(ports_mtx_);
+    if (action == "add")
+    {
+      info = serial::port_info(port);
+      ports_[port] = info;
+      event = PortEvent::ADDED;
+    }
+    else
+    {
+      auto it = ports_.find(port);
+      if (it == ports_.end())
+      {
+        return;
+      }
+      info = it->second;
+      ports_.erase(it);
+      event = PortEvent::REMOVED;
+    }
+  }
+  notify(event, info);
+}
+
+void PortWatcher::rescan()
+{
+  logger_->warn("PortWatcher: Uevents lost, rescanning the ports");
+  std::map<std::string, serial::PortInfo> ports;
+  for (const auto& info : serial::list_ports())
+  {
+    ports[info.port] = info;
+  }
+
+  // Differences with the device table, which is replaced
+  std::vector<std::pair<PortEvent, serial::PortInfo>> events;
+  {
+    std::scoped_lock lock(ports_mtx_);
+    for (const auto& [port, info] : ports_)
+    {
+      if (ports.count(port) == 0)
+      {
+        events.emplace_back(PortEvent::REMOVED, info);
+      }
+    }
+    for (const auto& [port, info] : ports)
+    {
+      if (ports_.count(port) == 0)
+      {
+        events.emplace_back(PortEvent::ADDED, info);
+      }
+    }
+    ports_.swap(ports);
+  }
+  for (const auto& [event, info] : events)
+  {
+    notify(event, info);
+  }
+}
+
+void PortWatcher::notify(const PortEvent& event, const serial::PortInfo& info)
+{
+  logger_->info("PortWatcher: Port " + info.port + (event == PortEvent::ADDED ? " added" : " removed"));
+
+  // Call a copy of the callbacks, skipping the ones removed meanwhile
+  std::scoped_lock notify_lock(notify_mtx_);
+  std::vector<std::pair<size_t, Callback>> callbacks;
+  {
+    std::scoped_lock lock(callbacks_mtx_);
+    callbacks.assign(callbacks_.begin(), callbacks_.end());
+  }
+  for (const auto& [id, callback] : callbacks)
+  {
+    {
+      std::scoped_lock lock(callbacks_mtx_);
+      if (callbacks_.count(id) == 0)
+      {
+        continue;
+      }
+    }
+    callback(event, info);
+  }
+}
+}  // namespace mspfci
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "mspfci/rate_controller.hpp"
+
+#include <algorithm>
+
+namespace mspfci
+{
+RateController::RateController(float min_freq, float max_freq)
+    : min_freq_(std::min(min_freq, max_freq))
+    , max_freq_(std::max(min_freq, max_freq))
+    , step_((max_freq_ - min_freq_) / 100.0f)
+    , freq_(min_freq_)
+{
+}
+
+float RateController::update(const bool& succeeded, const std::chrono::nanoseconds& rtt, const uint64_t& crc_errors)
+{
+  ++stats_.samples;
+
+  // Congestion signals
+  bool congested = false;
+  if (!succeeded)
+  {
+    ++stats_.failures;
+    congested = true;
+  }
+  if (!first_ && crc_errors > crc_errors_)
+  {
+    stats_.crc_errors += crc_errors - crc_errors_;
+    congested = true;
+  }
+  crc_errors_ = crc_errors;
+  first_ = false;
+  if (succeeded)
+  {
+    // Baseline, the lowest round trip of the previous and current windows
+    const auto now = std::chrono::steady_clock::now();
+    if (now - window_start_ > window)
+    {
+      previous_min_ = current_min_;
+      current_min_ = std::chrono::nanoseconds::max();
+      window_start_ = now;
+    }
+    current_min_ = std::min(current_min_, rtt);
+    const std::chrono::nanoseconds baseline = std::min(previous_min_, current_min_);
+    if (rtt > baseline * latency_factor && rtt > baseline + latency_tolerance)
+    {
+      // Back off once, the new round trip becoming the baseline
+      ++stats_.slow;
+      congested = true;
+      previous_min_ = rtt;
+      current_min_ = rtt;
+      window_start_ = now;
+    }
+    if (!congested && rtt.count() * static_cast<double>(freq_) > 1e9)
+    {
+      // The link is saturated rather than degraded, back off just below the rate the round trip sustains
+      ++stats_.overruns;
+      ++stats_.decreases;
+      freq_ = std::clamp(static_cast<float>(overrun_backoff * 1e9 / static_cast<double>(rtt.count())), min_freq_,
+                         max_freq_);
+      return freq_;
+    }
+  }
+
+  // Multiplicative decrease, additive increase
+  if (congested)
+  {
+    ++stats_.decreases;
+    freq_ = std::max(min_freq_, freq_ / 2.0f);
+  }
+  else
+  {
+    freq_ = std::min(max_freq_, freq_ + step_);
+  }
+  return freq_;
+}
+}  // namespace mspfci
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "mspfci/rc_stream.hpp"
+
+#include <stdexcept>
+
+#include "mspfci/periodic_callback.hpp"
+
+namespace mspfci
+{
+RCStream::RCStream(std::shared_ptr<Logger> logger, std::shared_ptr<Engine> engine, const float& rate)
+    : logger_(std::move(logger)), engine_(std::move(engine))
+{
+  if (!setRate(rate))
+  {
+    throw std::runtime_error("Invalid RC stream rate " + std::to_string(rate));
+  }
+
+  th_ = std::thread([this]() {
+    RCRawOut rc;
+    std::vector<uint16_t> channels;
+    Bytes msg;
+
+    // Loop while active, on a fixed schedule
+    auto next_time = std::chrono::steady_clock::now();
+    while (active_)
+    {
+      // Send the latest channels, once they have been published
+      if (snapshot(channels) != 0)
+      {
+        msg.clear();
+        rc.channels(channels);
+        if (!rc.encodeMessage(msg))
+        {
+          logger_->err("Failed to encode RC channels");
+        }
+        else if (!engine_->send(rc.getCode(), msg, Priority::CONTROL))
+        {
+          logger_->err("Failed to send RC channels");
+          link_up_ = false;
+        }
+        else
+        {
+          ++frames_;
+          link_up_ = true;
+        }
+      }
+
+      // Wait for the next period, skipping the missed ones
+      const std::chrono::nanoseconds period = period_;
+      next_time += period;
+      const auto now = std::chrono::steady_clock::now();
+      if (next_time < now)
+      {
+        next_time = now;
+      }
+      std::this_thread::sleep_until(next_time);
+    }
+  });
+}
+
+bool RCStream::setRate(const float& rate)
+{
+  if (!PeriodicCallback::isValidFrequency(rate))
+  {
+    logger_->err("RCStream::setRate: Invalid rate " + std::to_string(rate));
+    return false;
+  }
+  period_ = std::chrono::nanoseconds(std::chrono::nanoseconds::rep(std::nano::den / rate));
+  return true;
+}
+
+RCStream::~RCStream()
+{
+  // Deactivate and wait for the stream thread to complete its execution
+  active_ = false;
+  if (th_.joinable())
+  {
+    th_.join();
+  }
+}
+
+bool RCStream::set(const std::vector<uint16_t>& channels)
+{
+  if (channels.size() > max_channels)
+  {
+    logger_->err("RCStream::set: Too many RC channels");
+    return false;
+  }
+
+  // Single writer, the sequence is odd while writing
+  const uint64_t seq = seq_.load(std::memory_order_relaxed);
+  seq_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  size_.store(channels.size(), std::memory_order_relaxed);
+  for (size_t i = 0; i < channels.size(); ++i)
+  {
+    channels_[i].store(channels[i], std::memory_order_relaxed);
+  }
+
+  seq_.store(seq + 2, std::memory_order_release);
+  return true;
+}
+
+std::vector<uint16_t> RCStream::get() const
+{
+  std::vector<uint16_t> channels;
+  snapshot(channels);
+  return channels;
+}
+
+uint64_t RCStream::snapshot(std::vector<uint16_t>& channels) const
+{
+  uint64_t begin;
+  uint64_t end;
+  do
+  {
+    begin = seq_.load(std::memory_order_acquire);
+    if (begin & 1)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    const size_t size = size_.load(std::memory_order_relaxed);
+    channels.resize(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      channels[i] = channels_[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    end = seq_.load(std::memory_order_relaxed);
+  } while ((begin & 1) || begin != end);
+
+  return begin;
+}
+}  // namespace mspfci
\ No newline at end of file
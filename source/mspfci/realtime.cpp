@@ -0,0 +1,100 @@
+#include "mspfci/realtime.hpp"
+
+#include <malloc.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+namespace mspfci
+{
+/**
+ * @brief Get the name of a scheduling policy
+ * @param policy (int)
+ * @return name (std::string)
+ */
+static std::string policyName(int policy)
+{
+  switch (policy)
+  {
+    case SCHED_OTHER:
+      return "SCHED_OTHER";
+    case SCHED_FIFO:
+      return "SCHED_FIFO";
+    case SCHED_RR:
+      return "SCHED_RR";
+    default:
+      return "policy " + std::to_string(policy);
+  }
+}
+
+bool configureThread(const std::shared_ptr<Logger>& logger,
+                     pthread_t thread,
+                     const std::string& name,
+                     const int& policy,
+                     const int& priority,
+                     const std::vector<int>& cores)
+{
+  bool succeeded = true;
+
+  // Scheduling policy and priority, the priority being ignored by SCHED_OTHER
+  sched_param param = {};
+  param.sched_priority = (policy == SCHED_FIFO || policy == SCHED_RR) ? priority : 0;
+  if (const int error = pthread_setschedparam(thread, policy, &param); error != 0)
+  {
+    logger->err("Failed to set " + policyName(policy) + " priority " + std::to_string(param.sched_priority) +
+                " on the " + name + " thread: " + strerror(error) +
+                (error == EPERM ? " (CAP_SYS_NICE or a high enough RLIMIT_RTPRIO needed)" : ""));
+    succeeded = false;
+  }
+
+  // Affinity
+  if (!cores.empty())
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (const int& core : cores)
+    {
+      CPU_SET(core, &cpus);
+    }
+    if (const int error = pthread_setaffinity_np(thread, sizeof(cpus), &cpus); error != 0)
+    {
+      logger->err("Failed to pin the " + name + " thread: " + strerror(error));
+      succeeded = false;
+    }
+  }
+
+  return succeeded;
+}
+
+bool lockMemory(const std::shared_ptr<Logger>& logger, const size_t& prefault_heap)
+{
+  if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    logger->err(std::string("Failed to lock the memory: ") + strerror(errno) +
+                ((errno == EPERM || errno == ENOMEM) ? " (CAP_IPC_LOCK or a high enough RLIMIT_MEMLOCK needed)" : ""));
+    return false;
+  }
+
+  // Keep the freed memory in the heap instead of returning it to the system, and serve the large allocations from the
+  // heap as well, so that the prefaulted pages are reused
+  if (prefault_heap > 0)
+  {
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    const long page_size = ::sysconf(_SC_PAGESIZE);
+    void* heap = std::malloc(prefault_heap);
+    if (heap)
+    {
+      volatile char* pages = static_cast<volatile char*>(heap);
+      for (size_t i = 0; i < prefault_heap; i += static_cast<size_t>(page_size))
+      {
+        pages[i] = 0;
+      }
+      std::free(heap);
+    }
+  }
+  return true;
+}
+}  // namespace mspfci
\ No newline at end of file
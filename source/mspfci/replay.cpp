@@ -0,0 +1,144 @@
+#include "mspfci/replay.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "utils.hpp"
+
+namespace mspfci
+{
+/// Magic bytes at the beginning of a recording
+static constexpr char recording_magic[] = {'M', 'S', 'P', 'R'};
+
+RecordingTransport::RecordingTransport(std::unique_ptr<Transport> transport, const std::string& path)
+    : transport_(std::move(transport)), file_(path, std::ios::binary), start_time_(std::chrono::steady_clock::now())
+{
+  file_.write(recording_magic, sizeof(recording_magic));
+}
+
+size_t RecordingTransport::read(uint8_t* buffer, size_t size)
+{
+  size_t bytes_read = transport_->read(buffer, size);
+
+  // Append a record with the time of arrival and the bytes read
+  if (bytes_read > 0 && file_)
+  {
+    record_.clear();
+    const uint64_t time = static_cast<uint64_t>((std::chrono::steady_clock::now() - start_time_).count());
+    if (encode(time, record_) && encode(static_cast<uint32_t>(bytes_read), record_))
+    {
+      record_.insert(record_.end(), buffer, buffer + bytes_read);
+      file_.write(reinterpret_cast<const char*>(record_.data()), record_.size());
+    }
+  }
+
+  return bytes_read;
+}
+
+ReplayTransport::ReplayTransport(const std::string& path, const double& speed, const bool& loop)
+    : name_(path), speed_(speed), loop_(loop)
+{
+  std::ifstream file(path, std::ios::binary);
+  const Bytes content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  // Raw byte dumps are replayed as a single chunk
+  if (content.size() < sizeof(recording_magic) ||
+      !std::equal(std::begin(recording_magic), std::end(recording_magic), content.begin()))
+  {
+    append({std::chrono::nanoseconds::zero(), content});
+    return;
+  }
+
+  // Parse records, a truncated trailing record is dropped
+  size_t offset = sizeof(recording_magic);
+  uint64_t time;
+  uint32_t size;
+  while (decode(content, time, offset) && decode(content, size, offset + 8) && content.size() - offset - 12 >= size)
+  {
+    offset += 12;
+    append({std::chrono::nanoseconds(time), Bytes(content.begin() + offset, content.begin() + offset + size)});
+    offset += size;
+  }
+}
+
+ReplayTransport::ReplayTransport(std::vector<ReplayChunk> chunks, const double& speed, const bool& loop)
+    : speed_(speed), loop_(loop)
+{
+  for (const auto& chunk : chunks)
+  {
+    append(chunk);
+  }
+}
+
+void ReplayTransport::close()
+{
+  loop_ = false;
+  pos_ = stream_.size();
+  released_ = pos_;
+}
+
+size_t ReplayTransport::available()
+{
+  update();
+  return released_ - pos_;
+}
+
+size_t ReplayTransport::read(uint8_t* buffer, size_t size)
+{
+  update();
+  const size_t bytes_read = std::min(size, released_ - pos_);
+  std::copy(stream_.begin() + pos_, stream_.begin() + pos_ + bytes_read, buffer);
+  pos_ += bytes_read;
+  bytes_replayed_ += bytes_read;
+  return bytes_read;
+}
+
+size_t ReplayTransport::write(const ConstBuffer* buffers, size_t count)
+{
+  size_t bytes_written = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    bytes_written += buffers[i].size;
+  }
+  return bytes_written;
+}
+
+void ReplayTransport::append(const ReplayChunk& chunk)
+{
+  stream_.insert(stream_.end(), chunk.bytes.begin(), chunk.bytes.end());
+  chunks_.emplace_back(stream_.size(), chunk.time);
+}
+
+void ReplayTransport::update()
+{
+  // Restart once exhausted if looping
+  if (loop_ && !stream_.empty() && pos_ == stream_.size())
+  {
+    pos_ = 0;
+    next_chunk_ = 0;
+    released_ = 0;
+    started_ = false;
+  }
+
+  // As fast as possible, everything is released at once
+  if (speed_ <= 0.0)
+  {
+    released_ = stream_.size();
+    return;
+  }
+
+  // Original timing scaled by the speed factor
+  const auto now = std::chrono::steady_clock::now();
+  if (!started_)
+  {
+    start_time_ = now;
+    started_ = true;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>((now - start_time_) * speed_);
+  while (next_chunk_ < chunks_.size() && chunks_[next_chunk_].second <= elapsed)
+  {
+    released_ = chunks_[next_chunk_].first;
+    ++next_chunk_;
+  }
+}
+}  // namespace mspfci
\ No newline at end of file
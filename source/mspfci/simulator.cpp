@@ -0,0 +1,202 @@
+#include "mspfci/simulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mspfci
+{
+Simulator::Simulator(std::shared_ptr<Logger> logger, std::unique_ptr<Transport> transport, const MSPVer& ver)
+    : msp_(std::make_unique<MSP>(std::move(logger), std::move(transport), ver)), rc_(16, 1500)
+{
+  rc_.at(3) = 1000;
+
+  // Settings, with their size as stored by the firmware
+  settings_["gyro_lpf1_static_hz"] = {250, 0};
+  settings_["dterm_lpf1_static_hz"] = {75, 0};
+  settings_["motor_pwm_protocol"] = {6};
+  settings_["dshot_bidir"] = {0};
+  settings_["small_angle"] = {25};
+  settings_["vbat_max_cell_voltage"] = {0xAE, 0x01};
+  settings_["osd_units"] = {0};
+  settings_["failsafe_delay"] = {15};
+
+  th_ = std::thread([this]() {
+    MSPCode code;
+    Bytes request;
+    Bytes response;
+
+    // Serve requests until stopped or the connection is closed
+    while (active_)
+    {
+      request.clear();
+      if (!msp_->receive(code, request))
+      {
+        continue;
+      }
+      ++requests_;
+
+      response.clear();
+      const bool supported = handle(code, request, response);
+      const std::chrono::nanoseconds service_time = service_time_;
+      if (service_time > std::chrono::nanoseconds::zero())
+      {
+        std::this_thread::sleep_for(service_time);
+      }
+      if (!msp_->respond(code, response, !supported))
+      {
+        continue;
+      }
+    }
+  });
+}
+
+Simulator::~Simulator()
+{
+  active_ = false;
+  msp_->close();
+  if (th_.joinable())
+  {
+    th_.join();
+  }
+}
+
+std::vector<uint16_t> Simulator::getRC()
+{
+  std::scoped_lock lock(rc_mtx_);
+  return rc_;
+}
+
+Bytes Simulator::getSetting(const std::string& name)
+{
+  std::scoped_lock lock(settings_mtx_);
+  auto it = settings_.find(name);
+  return it == settings_.end() ? Bytes() : it->second;
+}
+
+bool Simulator::handle(const MSPCode& code, const Bytes& request, Bytes& response)
+{
+  bool succeeded = true;
+  const double t = static_cast<double>(requests_) * 1e-3;
+  switch (code)
+  {
+    case MSPCode::MSP_API_VERSION:
+      // MSP protocol 0, API 2.5
+      response = {0, 2, 5};
+      break;
+    case MSPCode::MSP_FC_VERSION:
+      // Firmware 4.5.1
+      response = {4, 5, 1};
+      break;
+    case MSPCode::MSP_UID:
+      // 96-bit unique id
+      succeeded &= encode(static_cast<uint32_t>(0x00350041), response);
+      succeeded &= encode(static_cast<uint32_t>(0x31365102), response);
+      succeeded &= encode(static_cast<uint32_t>(0x32333837), response);
+      break;
+    case MSPCode::MSP_DATAFLASH_SUMMARY:
+      // Ready and supported, 16 sectors of 64 KiB, synthetic log in use
+      succeeded &= encode(static_cast<uint8_t>(0x03), response);
+      succeeded &= encode(static_cast<uint32_t>(16), response);
+      succeeded &= encode(static_cast<uint32_t>(16 * 65536), response);
+      succeeded &= encode(static_cast<uint32_t>(flash_size), response);
+      break;
+    case MSPCode::MSP_DATAFLASH_READ:
+    {
+      // Address, size (capped as the firmware output buffer would), no compression, then the data. The synthetic
+      // log is a function of the address
+      uint32_t address = 0;
+      uint16_t size = 128;
+      succeeded &= decode(request, address) && (request.size() < 6 || decode(request, size, 4));
+      if (address >= flash_size)
+      {
+        size = 0;
+      }
+      size = static_cast<uint16_t>(std::min<size_t>({size, max_flash_read, flash_size - std::min(address, flash_size)}));
+      succeeded &= encode(address, response);
+      succeeded &= encode(size, response);
+      succeeded &= encode(static_cast<uint8_t>(0), response);
+      for (uint32_t i = address; i < address + size; ++i)
+      {
+        response.push_back(static_cast<uint8_t>(i ^ (i >> 8)));
+      }
+      break;
+    }
+    case MSPCode::MSP_RX_MAP:
+      // AETR channel map
+      response = {0, 1, 3, 2, 4, 5, 6, 7};
+      break;
+    case MSPCode::MSP_RC:
+    {
+      std::scoped_lock lock(rc_mtx_);
+      for (const uint16_t it : rc_)
+      {
+        succeeded &= encode(it, response);
+      }
+      break;
+    }
+    case MSPCode::MSP_SET_RAW_RC:
+    {
+      std::scoped_lock lock(rc_mtx_);
+      for (size_t i = 0; i < rc_.size(); ++i)
+      {
+        uint16_t rc;
+        if (decode(request, rc, 2 * i))
+        {
+          rc_.at(i) = rc;
+        }
+      }
+      break;
+    }
+    case MSPCode::MSP_RAW_IMU:
+      // Accelerometer (1g on z), gyroscope, magnetometer
+      succeeded &= encode(static_cast<int16_t>(100 * std::sin(t)), response);
+      succeeded &= encode(static_cast<int16_t>(100 * std::cos(t)), response);
+      succeeded &= encode(static_cast<int16_t>(512), response);
+      for (size_t i = 0; i < 6; ++i)
+      {
+        succeeded &= encode(static_cast<int16_t>(10 * std::sin(t + static_cast<double>(i))), response);
+      }
+      break;
+    case MSPCode::MSP_ALTITUDE:
+      // Altitude [cm] and vario [cm/s]
+      succeeded &= encode(static_cast<int32_t>(1000 + 100 * std::sin(t)), response);
+      succeeded &= encode(static_cast<int16_t>(100 * std::cos(t)), response);
+      break;
+    case MSPCode::MSP2_COMMON_SETTING:
+    case MSPCode::MSP2_COMMON_SET_SETTING:
+    {
+      // Null-terminated name, followed by the value to be set
+      const auto end = std::find(request.begin(), request.end(), 0);
+      if (end == request.end())
+      {
+        return false;
+      }
+      std::scoped_lock lock(settings_mtx_);
+      auto it = settings_.find(std::string(request.begin(), end));
+      if (it == settings_.end())
+      {
+        return false;
+      }
+      if (code == MSPCode::MSP2_COMMON_SETTING)
+      {
+        response = it->second;
+      }
+      else if (static_cast<size_t>(request.end() - end - 1) == it->second.size())
+      {
+        it->second.assign(end + 1, request.end());
+      }
+      else
+      {
+        return false;
+      }
+      break;
+    }
+    case MSPCode::MSP_EEPROM_WRITE:
+      ++eeprom_writes_;
+      break;
+    default:
+      return false;
+  }
+  return succeeded;
+}
+}  // namespace mspfci
\ No newline at end of file
@@ -0,0 +1,482 @@
+#include "mspfci/transport.hpp"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace mspfci
+{
+/**
+ * @brief Resolve host and port and return a connected non-blocking socket, throw on failure
+ * @param host (const reference to std::string)
+ * @param port (const reference to uint16_t)
+ * @param type socket type, SOCK_STREAM or SOCK_DGRAM (int)
+ * @param local_port local port to bind, 0 for an ephemeral one (uint16_t)
+ * @return socket file descriptor (int)
+ */
+static int connectSocket(const std::string& host, const uint16_t& port, int type, uint16_t local_port = 0)
+{
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = type;
+
+  addrinfo* res = nullptr;
+  int err = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+  if (err != 0)
+  {
+    throw std::runtime_error("Failed to resolve " + host + ": " + gai_strerror(err));
+  }
+
+  int fd = -1;
+  for (addrinfo* it = res; it != nullptr; it = it->ai_next)
+  {
+    fd = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+    if (fd == -1)
+    {
+      continue;
+    }
+
+    // Bind local port if requested
+    if (local_port != 0)
+    {
+      sockaddr_storage local;
+      memset(&local, 0, sizeof(local));
+      local.ss_family = static_cast<sa_family_t>(it->ai_family);
+      if (it->ai_family == AF_INET6)
+      {
+        reinterpret_cast<sockaddr_in6*>(&local)->sin6_port = htons(local_port);
+      }
+      else
+      {
+        reinterpret_cast<sockaddr_in*>(&local)->sin_port = htons(local_port);
+      }
+      if (::bind(fd, reinterpret_cast<sockaddr*>(&local), it->ai_addrlen) == -1)
+      {
+        ::close(fd);
+        fd = -1;
+        continue;
+      }
+    }
+
+    if (::connect(fd, it->ai_addr, it->ai_addrlen) == 0)
+    {
+      break;
+    }
+    ::close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+
+  if (fd == -1)
+  {
+    throw std::runtime_error("Failed to connect to " + host + ":" + std::to_string(port) + ": " + strerror(errno));
+  }
+
+  // Non-blocking, reads only return what is available
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  return fd;
+}
+
+/// Maximum number of blocks of a scatter-gather write
+static constexpr size_t max_iov = 16;
+
+/**
+ * @brief Fill an iovec array with the blocks to be written
+ * @param buffers array of count blocks (pointer to const ConstBuffer)
+ * @param count number of blocks (size_t)
+ * @param iov iovec array of at least count elements (pointer to iovec)
+ * @return total number of bytes (size_t)
+ */
+static size_t gather(const ConstBuffer* buffers, size_t count, iovec* iov)
+{
+  size_t size = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    iov[i].iov_base = const_cast<uint8_t*>(buffers[i].data);
+    iov[i].iov_len = buffers[i].size;
+    size += buffers[i].size;
+  }
+  return size;
+}
+
+/**
+ * @brief Write all the given blocks on a non-blocking socket, waiting for writability only if the socket buffer is
+ * full, until the deadline
+ * @param fd socket file descriptor (int)
+ * @param buffers array of count blocks (pointer to const ConstBuffer)
+ * @param count number of blocks (size_t)
+ * @param deadline (const reference to std::chrono::steady_clock::time_point)
+ * @return number of bytes written, less than the size of the blocks if the deadline has expired (size_t)
+ */
+static size_t sendAll(int fd, const ConstBuffer* buffers, size_t count,
+                      const std::chrono::steady_clock::time_point& deadline)
+{
+  // Send by batches of blocks, a frame fits in a single batch. The next batch is only sent once the previous one has
+  // been written entirely
+  if (count > max_iov)
+  {
+    iovec iov[max_iov];
+    const size_t size = gather(buffers, max_iov, iov);
+    const size_t bytes_written = sendAll(fd, buffers, max_iov, deadline);
+    return bytes_written < size ? bytes_written
+                                : bytes_written + sendAll(fd, buffers + max_iov, count - max_iov, deadline);
+  }
+
+  iovec iov[max_iov];
+  const size_t size = gather(buffers, count, iov);
+
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+
+  size_t bytes_written = 0;
+  while (bytes_written < size)
+  {
+    ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (n > 0)
+    {
+      bytes_written += static_cast<size_t>(n);
+
+      // Skip the blocks written
+      size_t advance = static_cast<size_t>(n);
+      while (advance > 0 && msg.msg_iovlen > 0)
+      {
+        if (advance < msg.msg_iov->iov_len)
+        {
+          msg.msg_iov->iov_base = static_cast<uint8_t*>(msg.msg_iov->iov_base) + advance;
+          msg.msg_iov->iov_len -= advance;
+          advance = 0;
+        }
+        else
+        {
+          advance -= msg.msg_iov->iov_len;
+          ++msg.msg_iov;
+          --msg.msg_iovlen;
+        }
+      }
+    }
+    else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      // Give up once the deadline has expired, e.g. the peer stopped reading
+      const auto remaining =
+          std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+      pollfd pfd = {fd, POLLOUT, 0};
+      if (remaining <= 0 || ::poll(&pfd, 1, static_cast<int>(remaining)) == 0)
+      {
+        break;
+      }
+    }
+    else if (n == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    else
+    {
+      break;
+    }
+  }
+  return bytes_written;
+}
+
+SerialTransport::SerialTransport(const std::string& port, const uint32_t& baudrate, const bool& low_latency)
+    : serial_(std::make_unique<serial::Serial>(port, baudrate, serial::Timeout::simpleTimeout(0)))
+    , low_latency_requested_(low_latency)
+{
+  // Only the driver latency is changed: MSP polls the bytes available and reads only those, a VMIN read would never
+  // take place, and the port stays non-blocking so that the writes honor their timeout
+  if (low_latency)
+  {
+    low_latency_ = serial_->setLowLatency(0, 0);
+  }
+}
+
+void SerialTransport::lose()
+{
+  try
+  {
+    serial_->close();
+  }
+  catch (const std::exception&)
+  {
+    // The port is closed anyway
+  }
+}
+
+size_t SerialTransport::available()
+{
+  try
+  {
+    return serial_->available();
+  }
+  catch (const std::exception&)
+  {
+    lose();
+    return 0;
+  }
+}
+
+size_t SerialTransport::read(uint8_t* buffer, size_t size)
+{
+  try
+  {
+    return serial_->readUnlocked(buffer, size);
+  }
+  catch (const std::exception&)
+  {
+    // e.g. "device reports readiness to read but returned no data" once the device is gone
+    lose();
+    return 0;
+  }
+}
+
+size_t SerialTransport::write(const ConstBuffer* buffers, size_t count)
+{
+  try
+  {
+    return serial_->write(buffers, count);
+  }
+  catch (const std::exception&)
+  {
+    lose();
+    return 0;
+  }
+}
+
+bool SerialTransport::reopen()
+{
+  lose();
+  try
+  {
+    serial_->open();
+    if (low_latency_requested_)
+    {
+      low_latency_ = serial_->setLowLatency(0, 0);
+    }
+    serial_->flushInput();
+    return true;
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+}
+
+TcpTransport::TcpTransport(const std::string& host, const uint16_t& port)
+    : fd_(connectSocket(host, port, SOCK_STREAM)), name_(host + ":" + std::to_string(port))
+{
+  // Frames are small and latency sensitive, disable Nagle's algorithm
+  int flag = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+void TcpTransport::close()
+{
+  const int fd = fd_.exchange(-1);
+  if (fd != -1)
+  {
+    ::close(fd);
+  }
+}
+
+size_t TcpTransport::available()
+{
+  const int fd = fd_;
+  int count = 0;
+  if (fd == -1 || ioctl(fd, FIONREAD, &count) == -1)
+  {
+    return 0;
+  }
+
+  // No data: peek, as bytes may arrive meanwhile. Only an end of stream, or an error, means the peer is gone
+  if (count == 0)
+  {
+    uint8_t byte;
+    const ssize_t n = ::recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+      close();
+      return 0;
+    }
+    if (n > 0 && ioctl(fd, FIONREAD, &count) == -1)
+    {
+      return 0;
+    }
+  }
+  return static_cast<size_t>(count);
+}
+
+size_t TcpTransport::read(uint8_t* buffer, size_t size)
+{
+  const int fd = fd_;
+  if (fd == -1 || size == 0)
+  {
+    return 0;
+  }
+  ssize_t n = ::recv(fd, buffer, size, 0);
+  if (n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+  {
+    close();
+  }
+  return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+size_t TcpTransport::write(const ConstBuffer* buffers, size_t count)
+{
+  const int fd = fd_;
+  if (fd == -1)
+  {
+    return 0;
+  }
+  return sendAll(fd, buffers, count, std::chrono::steady_clock::now() + write_timeout_.load());
+}
+
+UdpTransport::UdpTransport(const std::string& host, const uint16_t& port, const uint16_t& local_port)
+    : fd_(connectSocket(host, port, SOCK_DGRAM, local_port)), name_(host + ":" + std::to_string(port))
+{
+}
+
+void UdpTransport::close()
+{
+  if (fd_ != -1)
+  {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+size_t UdpTransport::available()
+{
+  receive();
+  return rx_buffer_.size();
+}
+
+size_t UdpTransport::read(uint8_t* buffer, size_t size)
+{
+  receive();
+  const size_t bytes_read = std::min(size, rx_buffer_.size());
+  std::copy(rx_buffer_.begin(), rx_buffer_.begin() + bytes_read, buffer);
+  rx_buffer_.erase(rx_buffer_.begin(), rx_buffer_.begin() + bytes_read);
+  return bytes_read;
+}
+
+size_t UdpTransport::write(const ConstBuffer* buffers, size_t count)
+{
+  if (fd_ == -1)
+  {
+    return 0;
+  }
+
+  // The blocks are sent as a single datagram
+  if (count > max_iov)
+  {
+    Bytes datagram;
+    for (size_t i = 0; i < count; ++i)
+    {
+      datagram.insert(datagram.end(), buffers[i].data, buffers[i].data + buffers[i].size);
+    }
+    return write(datagram);
+  }
+  iovec iov[max_iov];
+  gather(buffers, count, iov);
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+  ssize_t n = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+  return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+void UdpTransport::receive()
+{
+  uint8_t datagram[65536];
+  while (fd_ != -1)
+  {
+    ssize_t n = ::recv(fd_, datagram, sizeof(datagram), 0);
+    if (n <= 0)
+    {
+      break;
+    }
+    rx_buffer_.insert(rx_buffer_.end(), datagram, datagram + n);
+  }
+}
+
+std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>> LoopbackTransport::pair(
+    size_t capacity)
+{
+  // Round capacity up to a power of two so that indices wrap with a mask
+  size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+
+  auto a = std::make_shared<Ring>(size);
+  auto b = std::make_shared<Ring>(size);
+  return {std::unique_ptr<LoopbackTransport>(new LoopbackTransport(a, b)),
+          std::unique_ptr<LoopbackTransport>(new LoopbackTransport(b, a))};
+}
+
+void LoopbackTransport::close()
+{
+  rx_->closed = true;
+  tx_->closed = true;
+}
+
+size_t LoopbackTransport::available()
+{
+  return rx_->head.load(std::memory_order_acquire) - rx_->tail.load(std::memory_order_relaxed);
+}
+
+size_t LoopbackTransport::read(uint8_t* buffer, size_t size)
+{
+  const size_t tail = rx_->tail.load(std::memory_order_relaxed);
+  const size_t bytes_read = std::min(size, rx_->head.load(std::memory_order_acquire) - tail);
+  for (size_t i = 0; i < bytes_read; ++i)
+  {
+    buffer[i] = rx_->buffer[(tail + i) & rx_->mask];
+  }
+  rx_->tail.store(tail + bytes_read, std::memory_order_release);
+  return bytes_read;
+}
+
+size_t LoopbackTransport::write(const ConstBuffer* buffers, size_t count)
+{
+  if (!isOpen())
+  {
+    return 0;
+  }
+  const size_t head = tx_->head.load(std::memory_order_relaxed);
+  size_t space = tx_->buffer.size() - (head - tx_->tail.load(std::memory_order_acquire));
+  size_t bytes_written = 0;
+  for (size_t i = 0; i < count && space > 0; ++i)
+  {
+    const size_t size = std::min(space, buffers[i].size);
+    for (size_t j = 0; j < size; ++j)
+    {
+      tx_->buffer[(head + bytes_written + j) & tx_->mask] = buffers[i].data[j];
+    }
+    bytes_written += size;
+    space -= size;
+  }
+
+  // Publish all the blocks at once
+  tx_->head.store(head + bytes_written, std::memory_order_release);
+  return bytes_written;
+}
+}  // namespace mspfci
\ No newline at end of file
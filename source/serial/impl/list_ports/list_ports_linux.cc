@@ -295,21 +295,22 @@ vector<PortInfo> serial::list_ports()
   {
     string device = *iter++;
 
-    vector<string> sysfs_info = get_sysfs_info(device);
-
-    string friendly_name = sysfs_info[0];
+    results.push_back(serial::port_info(device));
+  }
 
-    string hardware_id = sysfs_info[1];
+  return results;
+}
 
-    PortInfo device_entry;
-    device_entry.port = device;
-    device_entry.description = friendly_name;
-    device_entry.hardware_id = hardware_id;
+PortInfo serial::port_info(const string& port)
+{
+  vector<string> sysfs_info = get_sysfs_info(port);
 
-    results.push_back(device_entry);
-  }
+  PortInfo device_entry;
+  device_entry.port = port;
+  device_entry.description = sysfs_info[0];
+  device_entry.hardware_id = sysfs_info[1];
 
-  return results;
+  return device_entry;
 }
 
 #endif  // defined(__linux__)
@@ -24,6 +24,8 @@
 #endif
 
 #include <sys/select.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <sys/time.h>
 #include <time.h>
 #ifdef __MACH__
@@ -46,6 +48,28 @@
 #include <IOKit/serial/ioss.h>
 #endif
 
+#if defined(__linux__) && defined(TCGETS2)
+// struct termios2 from <asm/termbits.h>, which can not be included along
+// with <termios.h>. It carries the input and output speeds as integers,
+// which are used as is when the BOTHER speed is selected.
+struct termios2 {
+  tcflag_t c_iflag;
+  tcflag_t c_oflag;
+  tcflag_t c_cflag;
+  tcflag_t c_lflag;
+  cc_t c_line;
+  cc_t c_cc[19];
+  speed_t c_ispeed;
+  speed_t c_ospeed;
+};
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#ifndef IBSHIFT
+#define IBSHIFT 16
+#endif
+#endif
+
 using std::string;
 using std::stringstream;
 using std::invalid_argument;
@@ -96,6 +120,33 @@ MillisecondTimer::timespec_now ()
   return time;
 }
 
+/*
+ * Sets O_NONBLOCK on a file descriptor (if enabled) for the lifetime of the
+ * object, and restores the previous flags on destruction (even when an
+ * exception is thrown).
+ */
+class ScopedNonBlocking {
+public:
+  ScopedNonBlocking (int fd, bool enable)
+  : fd_ (fd), flags_ (enable ? fcntl (fd, F_GETFL) : -1) {
+    if (flags_ != -1 && !(flags_ & O_NONBLOCK)) {
+      fcntl (fd_, F_SETFL, flags_ | O_NONBLOCK);
+    }
+  }
+  ~ScopedNonBlocking () {
+    if (flags_ != -1 && !(flags_ & O_NONBLOCK)) {
+      fcntl (fd_, F_SETFL, flags_);
+    }
+  }
+private:
+  // Disable copy constructors
+  ScopedNonBlocking(const ScopedNonBlocking&);
+  const ScopedNonBlocking& operator=(ScopedNonBlocking);
+
+  int fd_;
+  int flags_;
+};
+
 timespec
 timespec_from_ms (const uint32_t millis)
 {
@@ -110,8 +161,9 @@ Serial::SerialImpl::SerialImpl (const string &port, unsigned long baudrate,
                                 parity_t parity, stopbits_t stopbits,
                                 flowcontrol_t flowcontrol)
   : port_ (port), fd_ (-1), is_open_ (false), xonxoff_ (false), rtscts_ (false),
-    baudrate_ (baudrate), parity_ (parity),
-    bytesize_ (bytesize), stopbits_ (stopbits), flowcontrol_ (flowcontrol)
+    baudrate_ (baudrate), effective_baudrate_ (baudrate), parity_ (parity),
+    bytesize_ (bytesize), stopbits_ (stopbits), flowcontrol_ (flowcontrol),
+    vmin_ (0), vtime_ (0)
 {
   pthread_mutex_init(&this->read_mutex, NULL);
   pthread_mutex_init(&this->write_mutex, NULL);
@@ -152,7 +204,14 @@ Serial::SerialImpl::open ()
     }
   }
 
-  reconfigurePort();
+  try {
+    reconfigurePort();
+  } catch (...) {
+    // Do not leak the descriptor, e.g. when a device vanishes while it is reopened
+    ::close (fd_);
+    fd_ = -1;
+    throw;
+  }
   is_open_ = true;
 }
 
@@ -404,11 +463,13 @@ Serial::SerialImpl::reconfigurePort ()
 #endif
 
   // http://www.unixwiz.net/techtips/termios-vmin-vtime.html
-  // this basically sets the read call up to be a polling read,
+  // by default this basically sets the read call up to be a polling read,
   // but we are using select to ensure there is data available
-  // to read before each call, so we should never needlessly poll
-  options.c_cc[VMIN] = 0;
-  options.c_cc[VTIME] = 0;
+  // to read before each call, so we should never needlessly poll.
+  // In low latency mode (see setLowLatency) the reads are blocking and
+  // return once VMIN bytes are received.
+  options.c_cc[VMIN] = vmin_;
+  options.c_cc[VTIME] = vtime_;
 
   // activate settings
   ::tcsetattr (fd_, TCSANOW, &options);
@@ -427,6 +488,23 @@ Serial::SerialImpl::reconfigurePort ()
       THROW (IOException, errno);
     }
     // Linux Support
+#elif defined(__linux__) && defined (TCSETS2)
+    // Arbitrary baud rates through termios2 and BOTHER, supported by the
+    // UART and USB-serial drivers that reject custom divisors
+    struct termios2 tio2;
+
+    if (-1 == ioctl (fd_, TCGETS2, &tio2)) {
+      THROW (IOException, errno);
+    }
+
+    tio2.c_cflag &= (tcflag_t) ~(CBAUD | (CBAUD << IBSHIFT));
+    tio2.c_cflag |= (tcflag_t) (BOTHER | (BOTHER << IBSHIFT));
+    tio2.c_ispeed = static_cast<speed_t> (baudrate_);
+    tio2.c_ospeed = static_cast<speed_t> (baudrate_);
+
+    if (-1 == ioctl (fd_, TCSETS2, &tio2)) {
+      THROW (IOException, errno);
+    }
 #elif defined(__linux__) && defined (TIOCSSERIAL)
     struct serial_struct ser;
 
@@ -448,8 +526,18 @@ Serial::SerialImpl::reconfigurePort ()
 #endif
   }
 
+  // Read back the baud rate the driver actually set, which may differ from
+  // the requested one (nearest achievable divisor)
+  effective_baudrate_ = baudrate_;
+#if defined(__linux__) && defined (TCGETS2)
+  struct termios2 actual;
+  if (-1 != ioctl (fd_, TCGETS2, &actual) && actual.c_ospeed != 0) {
+    effective_baudrate_ = actual.c_ospeed;
+  }
+#endif
+
   // Update byte_time_ based on the new settings.
-  uint32_t bit_time_ns = 1e9 / baudrate_;
+  uint32_t bit_time_ns = 1e9 / effective_baudrate_;
   byte_time_ns_ = bit_time_ns * (1 + bytesize_ + parity_ + stopbits_);
 
   // Compensate for the stopbits_one_point_five enum being equal to int 3,
@@ -463,16 +551,17 @@ void
 Serial::SerialImpl::close ()
 {
   if (is_open_ == true) {
+    is_open_ = false;
     if (fd_ != -1) {
+      // The descriptor is released even if close fails (e.g. EIO from a
+      // vanished device), never retry it
       int ret;
       ret = ::close (fd_);
-      if (ret == 0) {
-        fd_ = -1;
-      } else {
+      fd_ = -1;
+      if (ret != 0) {
         THROW (IOException, errno);
       }
     }
-    is_open_ = false;
   }
 }
 
@@ -482,6 +571,12 @@ Serial::SerialImpl::isOpen () const
   return is_open_;
 }
 
+int
+Serial::SerialImpl::getFd () const
+{
+  return fd_;
+}
+
 size_t
 Serial::SerialImpl::available ()
 {
@@ -613,11 +708,21 @@ Serial::SerialImpl::read (uint8_t *buf, size_t size)
 
 size_t
 Serial::SerialImpl::write (const uint8_t *data, size_t length)
+{
+  serial::ConstBuffer buffer = {data, length};
+  return write (&buffer, 1);
+}
+
+size_t
+Serial::SerialImpl::write (const serial::ConstBuffer *buffers, size_t count)
 {
   if (is_open_ == false) {
     throw PortNotOpenedException ("Serial::write");
   }
-  fd_set writefds;
+  size_t length = 0;
+  for (size_t i = 0; i < count; ++i) {
+    length += buffers[i].size;
+  }
   size_t bytes_written = 0;
 
   // Calculate total timeout in milliseconds t_c + (t_m * N)
@@ -625,88 +730,86 @@ Serial::SerialImpl::write (const uint8_t *data, size_t length)
   total_timeout_ms += timeout_.write_timeout_multiplier * static_cast<long> (length);
   MillisecondTimer total_timeout(total_timeout_ms);
 
-  bool first_iteration = true;
-  while (bytes_written < length) {
-    int64_t timeout_remaining_ms = total_timeout.remaining();
-    // Only consider the timeout if it's not the first iteration of the loop
-    // otherwise a timeout of 0 won't be allowed through
-    if (!first_iteration && (timeout_remaining_ms <= 0)) {
-      // Timed out
-      break;
-    }
-    first_iteration = false;
+  // The port is blocking in low latency mode (VMIN set, see setLowLatency),
+  // where a write would wait for room without timeout. Make it
+  // non-blocking while writing, so that a full tty buffer is waited for
+  // with poll below, and the timeout honored
+  ScopedNonBlocking non_blocking (fd_, vmin_ > 0);
 
-    timespec timeout(timespec_from_ms(timeout_remaining_ms));
+  // Position of the first byte not yet written
+  size_t buffer_idx = 0;
+  size_t buffer_offset = 0;
 
-    FD_ZERO (&writefds);
-    FD_SET (fd_, &writefds);
-
-    // Do the select
-    int r = pselect (fd_ + 1, NULL, &writefds, NULL, &timeout, NULL);
-
-    // Figure out what happened by looking at select's response 'r'
-    /** Error **/
-    if (r < 0) {
-      // Select was interrupted, try again
-      if (errno == EINTR) {
-        continue;
+  while (bytes_written < length) {
+    // Gather the remaining buffers, frames are small so a single batch
+    // almost always covers them all
+    struct iovec iov[16];
+    int iovcnt = 0;
+    for (size_t i = buffer_idx; i < count && iovcnt < 16; ++i) {
+      size_t offset = (i == buffer_idx) ? buffer_offset : 0;
+      if (buffers[i].size > offset) {
+        iov[iovcnt].iov_base = const_cast<uint8_t*> (buffers[i].data + offset);
+        iov[iovcnt].iov_len = buffers[i].size - offset;
+        ++iovcnt;
       }
-      // Otherwise there was some error
-      THROW (IOException, errno);
     }
-    /** Timeout **/
-    if (r == 0) {
-      break;
+
+    // Attempt the write right away, the tty buffer almost always has room
+    // for a frame, and only wait for writability when it is full
+    ssize_t bytes_written_now = ::writev (fd_, iov, iovcnt);
+
+    if (bytes_written_now == -1 && errno == EINTR) {
+      continue;
     }
-    /** Port ready to write **/
-    if (r > 0) {
-      // Make sure our file descriptor is in the ready to write list
-      if (FD_ISSET (fd_, &writefds)) {
-        // This will write some
-        ssize_t bytes_written_now =
-          ::write (fd_, data + bytes_written, length - bytes_written);
-
-        // even though pselect returned readiness the call might still be 
-        // interrupted. In that case simply retry.
-        if (bytes_written_now == -1 && errno == EINTR) {
+    if (bytes_written_now == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      int64_t timeout_remaining_ms = total_timeout.remaining();
+      if (timeout_remaining_ms <= 0) {
+        // Timed out
+        break;
+      }
+      pollfd pfd = {fd_, POLLOUT, 0};
+      int r = ::poll (&pfd, 1, static_cast<int> (timeout_remaining_ms));
+      if (r < 0) {
+        // Poll was interrupted, try again
+        if (errno == EINTR) {
           continue;
         }
+        // Otherwise there was some error
+        THROW (IOException, errno);
+      }
+      if (r == 0) {
+        // Timed out
+        break;
+      }
+      continue;
+    }
+    if (bytes_written_now < 1) {
+      // Disconnected devices, at least on Linux, show the
+      // behavior that they are always ready to write immediately
+      // but writing returns nothing.
+      std::stringstream strs;
+      strs << "device reports readiness to write but "
+        "returned no data (device disconnected?)";
+      strs << " errno=" << errno;
+      strs << " bytes_written_now= " << bytes_written_now;
+      strs << " bytes_written=" << bytes_written;
+      strs << " length=" << length;
+      throw SerialException(strs.str().c_str());
+    }
 
-        // write should always return some data as select reported it was
-        // ready to write when we get to this point.
-        if (bytes_written_now < 1) {
-          // Disconnected devices, at least on Linux, show the
-          // behavior that they are always ready to write immediately
-          // but writing returns nothing.
-          std::stringstream strs;
-          strs << "device reports readiness to write but "
-            "returned no data (device disconnected?)";
-          strs << " errno=" << errno;
-          strs << " bytes_written_now= " << bytes_written_now;
-          strs << " bytes_written=" << bytes_written;
-          strs << " length=" << length;
-          throw SerialException(strs.str().c_str());
-        }
-        // Update bytes_written
-        bytes_written += static_cast<size_t> (bytes_written_now);
-        // If bytes_written == size then we have written everything we need to
-        if (bytes_written == length) {
-          break;
-        }
-        // If bytes_written < size then we have more to write
-        if (bytes_written < length) {
-          continue;
-        }
-        // If bytes_written > size then we have over written, which shouldn't happen
-        if (bytes_written > length) {
-          throw SerialException ("write over wrote, too many bytes where "
-                                 "written, this shouldn't happen, might be "
-                                 "a logical error!");
-        }
+    // Update bytes_written, and advance the position
+    bytes_written += static_cast<size_t> (bytes_written_now);
+    size_t advance = static_cast<size_t> (bytes_written_now);
+    while (advance > 0 && buffer_idx < count) {
+      size_t left = buffers[buffer_idx].size - buffer_offset;
+      if (advance < left) {
+        buffer_offset += advance;
+        advance = 0;
+      } else {
+        advance -= left;
+        ++buffer_idx;
+        buffer_offset = 0;
       }
-      // This shouldn't happen, if r > 0 our fd has to be in the list!
-      THROW (IOException, "select reports ready to write, but our fd isn't"
-                          " in the list, this shouldn't happen!");
     }
   }
   return bytes_written;
@@ -750,6 +853,12 @@ Serial::SerialImpl::getBaudrate () const
   return baudrate_;
 }
 
+unsigned long
+Serial::SerialImpl::getEffectiveBaudrate () const
+{
+  return effective_baudrate_;
+}
+
 void
 Serial::SerialImpl::setBytesize (serial::bytesize_t bytesize)
 {
@@ -806,6 +915,57 @@ Serial::SerialImpl::getFlowcontrol () const
   return flowcontrol_;
 }
 
+serial::LowLatencyStatus
+Serial::SerialImpl::setLowLatency (uint8_t vmin, uint8_t vtime)
+{
+  if (is_open_ == false) {
+    throw PortNotOpenedException ("Serial::setLowLatency");
+  }
+
+  low_latency_ = LowLatencyStatus ();
+
+#if defined(__linux__) && defined (TIOCSSERIAL) && defined (ASYNC_LOW_LATENCY)
+  // Ask the driver to push received bytes immediately, then read the flag
+  // back, as drivers not supporting it (e.g. most CDC-ACM) may ignore it
+  struct serial_struct ser;
+  if (-1 != ioctl (fd_, TIOCGSERIAL, &ser)) {
+    ser.flags |= ASYNC_LOW_LATENCY;
+    if (-1 != ioctl (fd_, TIOCSSERIAL, &ser) &&
+        -1 != ioctl (fd_, TIOCGSERIAL, &ser)) {
+      low_latency_.async_low_latency = (ser.flags & ASYNC_LOW_LATENCY) != 0;
+    }
+  }
+#endif
+
+  // VMIN/VTIME only apply to blocking reads
+  int flags = fcntl (fd_, F_GETFL);
+  if (flags == -1) {
+    THROW (IOException, errno);
+  }
+  flags = (vmin > 0) ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+  if (-1 == fcntl (fd_, F_SETFL, flags)) {
+    THROW (IOException, errno);
+  }
+
+  vmin_ = vmin;
+  vtime_ = vtime;
+  reconfigurePort ();
+
+  struct termios options;
+  if (-1 != tcgetattr (fd_, &options)) {
+    low_latency_.vmin_vtime = options.c_cc[VMIN] == vmin_ &&
+                              options.c_cc[VTIME] == vtime_;
+  }
+
+  return low_latency_;
+}
+
+serial::LowLatencyStatus
+Serial::SerialImpl::getLowLatency () const
+{
+  return low_latency_;
+}
+
 void
 Serial::SerialImpl::flush ()
 {
@@ -357,6 +357,20 @@ Serial::SerialImpl::write (const uint8_t *data, size_t length)
   return (size_t) (bytes_written);
 }
 
+size_t
+Serial::SerialImpl::write (const serial::ConstBuffer *buffers, size_t count)
+{
+  size_t bytes_written = 0;
+  for (size_t i = 0; i < count; ++i) {
+    size_t bytes_written_now = write (buffers[i].data, buffers[i].size);
+    bytes_written += bytes_written_now;
+    if (bytes_written_now != buffers[i].size) {
+      break;
+    }
+  }
+  return bytes_written;
+}
+
 void
 Serial::SerialImpl::setPort (const string &port)
 {
@@ -399,6 +413,12 @@ Serial::SerialImpl::getBaudrate () const
   return baudrate_;
 }
 
+unsigned long
+Serial::SerialImpl::getEffectiveBaudrate () const
+{
+  return baudrate_;
+}
+
 void
 Serial::SerialImpl::setBytesize (serial::bytesize_t bytesize)
 {
@@ -459,6 +479,22 @@ Serial::SerialImpl::getFlowcontrol () const
   return flowcontrol_;
 }
 
+serial::LowLatencyStatus
+Serial::SerialImpl::setLowLatency (uint8_t /*vmin*/, uint8_t /*vtime*/)
+{
+  if (is_open_ == false) {
+    throw PortNotOpenedException ("Serial::setLowLatency");
+  }
+  // Not supported, USB-serial latency timers are set through the driver
+  return serial::LowLatencyStatus ();
+}
+
+serial::LowLatencyStatus
+Serial::SerialImpl::getLowLatency () const
+{
+  return serial::LowLatencyStatus ();
+}
+
 void
 Serial::SerialImpl::flush ()
 {
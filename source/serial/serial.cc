@@ -31,6 +31,8 @@ using serial::bytesize_t;
 using serial::parity_t;
 using serial::stopbits_t;
 using serial::flowcontrol_t;
+using serial::LowLatencyStatus;
+using serial::ConstBuffer;
 
 class Serial::ScopedReadLock {
 public:
@@ -95,6 +97,14 @@ Serial::isOpen () const
   return pimpl_->isOpen ();
 }
 
+#if !defined(_WIN32)
+int
+Serial::getFd () const
+{
+  return pimpl_->getFd ();
+}
+#endif
+
 size_t
 Serial::available ()
 {
@@ -127,23 +137,31 @@ Serial::read (uint8_t *buffer, size_t size)
   return this->pimpl_->read (buffer, size);
 }
 
+size_t
+Serial::readUnlocked (uint8_t *buffer, size_t size)
+{
+  return this->pimpl_->read (buffer, size);
+}
+
 size_t
 Serial::read (std::vector<uint8_t> &buffer, size_t size)
 {
   ScopedReadLock lock(this->pimpl_);
-  uint8_t *buffer_ = new uint8_t[size];
+  // Read in place at the end of the caller's buffer, which does not
+  // allocate once its capacity is large enough
+  const size_t offset = buffer.size ();
+  buffer.resize (offset + size);
   size_t bytes_read = 0;
 
   try {
-    bytes_read = this->pimpl_->read (buffer_, size);
+    bytes_read = this->pimpl_->read (buffer.data () + offset, size);
   }
   catch (const std::exception &e) {
-    delete[] buffer_;
+    buffer.resize (offset);
     throw;
   }
 
-  buffer.insert (buffer.end (), buffer_, buffer_+bytes_read);
-  delete[] buffer_;
+  buffer.resize (offset + bytes_read);
   return bytes_read;
 }
 
@@ -151,17 +169,18 @@ size_t
 Serial::read (std::string &buffer, size_t size)
 {
   ScopedReadLock lock(this->pimpl_);
-  uint8_t *buffer_ = new uint8_t[size];
+  const size_t offset = buffer.size ();
+  buffer.resize (offset + size);
   size_t bytes_read = 0;
   try {
-    bytes_read = this->pimpl_->read (buffer_, size);
+    bytes_read = this->pimpl_->read (
+        reinterpret_cast<uint8_t*>(&buffer[offset]), size);
   }
   catch (const std::exception &e) {
-    delete[] buffer_;
+    buffer.resize (offset);
     throw;
   }
-  buffer.append (reinterpret_cast<const char*>(buffer_), bytes_read);
-  delete[] buffer_;
+  buffer.resize (offset + bytes_read);
   return bytes_read;
 }
 
@@ -273,6 +292,13 @@ Serial::write (const uint8_t *data, size_t size)
   return this->write_(data, size);
 }
 
+size_t
+Serial::write (const ConstBuffer *buffers, size_t count)
+{
+  ScopedWriteLock lock(this->pimpl_);
+  return pimpl_->write (buffers, count);
+}
+
 size_t
 Serial::write_ (const uint8_t *data, size_t length)
 {
@@ -319,6 +345,12 @@ Serial::getBaudrate () const
   return uint32_t(pimpl_->getBaudrate ());
 }
 
+uint32_t
+Serial::getEffectiveBaudrate () const
+{
+  return uint32_t(pimpl_->getEffectiveBaudrate ());
+}
+
 void
 Serial::setBytesize (bytesize_t bytesize)
 {
@@ -367,6 +399,20 @@ Serial::getFlowcontrol () const
   return pimpl_->getFlowcontrol ();
 }
 
+LowLatencyStatus
+Serial::setLowLatency (uint8_t vmin, uint8_t vtime)
+{
+  ScopedReadLock rlock(this->pimpl_);
+  ScopedWriteLock wlock(this->pimpl_);
+  return pimpl_->setLowLatency (vmin, vtime);
+}
+
+LowLatencyStatus
+Serial::getLowLatency () const
+{
+  return pimpl_->getLowLatency ();
+}
+
 void Serial::flush ()
 {
   ScopedReadLock rlock(this->pimpl_);